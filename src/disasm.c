@@ -0,0 +1,116 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "disasm.h"
+#include "asm6800.h"
+#include "unasm6800.h"
+#include "workslate.h"
+
+#define ROM_BASE      0x8000    // banked ROM from here up
+#define BANKS         4
+#define FACTS_BANK    3         // the bank the facts file was written for
+#define LIVE_BYTES    256       // RAM bytes refreshed per line (FCB facts can be long)
+#define LABEL_AT      15        // where unasm_line() puts the label field
+#define LABEL_LEN     11
+
+/////////////////////////////
+// Disassembly cache
+//
+// unasm_line() wants the whole address space as one array, so 'image' holds
+// the ROM of one bank (reloaded only when another bank is asked for) and,
+// just before each RAM line is decoded, the RAM it can reach.  ROM lines are
+// kept by start address, so listing the same code again -- or from a
+// different starting point that falls into step -- is a string copy.
+
+struct cached {
+    char *text;                 // NULL = not decoded yet
+    uint16_t next;
+};
+
+static struct cached *cache[BANKS];            // ROM_BASE..FFFF, allocated on first use
+static unsigned char image[0x10000 + 2];       // +2: an FDB at FFFF reads past the end
+static int image_bank = -1;
+
+static void load_image(int bank, uint16_t addr)
+{
+    if (image_bank != bank) {
+        for (int a = ROM_BASE; a < 0x10000; a++) {
+            image[a] = mpeek(bank, a);
+        }
+        image_bank = bank;
+    }
+    if (addr < ROM_BASE) {
+        for (int a = addr; a < addr + LIVE_BYTES && a < ROM_BASE; a++) {
+            image[a] = mpeek(bank, a);
+        }
+    }
+}
+
+static uint16_t decode(int bank, uint16_t addr, char *buf)
+{
+    unsigned short pc = addr;
+    int target;
+
+    load_image(bank, addr);
+    facts_end = (bank == FACTS_BANK) ? 0x10000 : ROM_BASE;
+    unasm_line(image, &pc, buf, &target, 0);
+    facts_end = 0x10000;
+    return pc;
+}
+
+uint16_t disasm_line(int bank, uint16_t addr, char *buf)
+{
+    struct cached *c = NULL;
+    char line[DISASM_LINE];
+    const char *label;
+    uint16_t next;
+
+    bank &= BANKS - 1;
+    if (addr >= ROM_BASE) {
+        if (!cache[bank]) {
+            cache[bank] = (struct cached *) calloc(0x10000 - ROM_BASE, sizeof(struct cached));
+        }
+        if (cache[bank]) {
+            c = &cache[bank][addr - ROM_BASE];
+        }
+    }
+    if (c && c->text) {
+        strcpy(line, c->text);
+        next = c->next;
+    } else {
+        next = decode(bank, addr, line);
+        if (c) {
+            c->text = strdup(line);
+            c->next = next;
+        }
+    }
+
+    // The symbol table changes (clr, assembling), so its labels go on as the
+    // line is listed.  Like the trace, a symbol wins over a fact's label.
+    label = find_label(addr);
+    if (label && strlen(line) >= LABEL_AT + LABEL_LEN) {
+        snprintf(buf, DISASM_LINE, "%.*s%-10s %s", LABEL_AT, line, label, line + LABEL_AT + LABEL_LEN);
+    } else {
+        strcpy(buf, line);
+    }
+    return next;
+}
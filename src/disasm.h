@@ -0,0 +1,22 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Disassembly for the monitor, any ROM bank, without disturbing the machine.
+ *
+ * Memory is read with mpeek(), so I/O registers aren't touched and the bank
+ * doesn't have to be switched in.  Lines in banked ROM never change, so they
+ * are decoded once and kept per bank; lines in RAM are decoded every time.
+ * Labels come from the facts (which describe bank 3) and the symbol table.
+ */
+
+#ifndef DISASM_H
+#define DISASM_H
+
+#include <stdint.h>
+
+#define DISASM_LINE   512       // longest line, with the fact comment
+
+// Unassemble the instruction at bank.addr into buf, returns the next address
+uint16_t disasm_line(int bank, uint16_t addr, char *buf);
+
+#endif
@@ -36,6 +36,49 @@ int scrn[WIDTH*HEIGHT]; /* Screen contents */
 int scrn_x = 0; /* Screen cursor position */
 int scrn_y = 0;
 
+/* Rows where scrn and screen may differ: only these are compared by update() */
+
+static unsigned char dirty[HEIGHT];
+
+/* Output to the real terminal is collected here, and written all at once at
+ * the end of update() */
+
+#define OUTSIZE 16384
+
+static char outbuf[OUTSIZE];
+static int outlen = 0;
+
+static void real_flush()
+{
+	fflush(stdout); /* Anything printed elsewhere goes first */
+	if (outlen && write(fileno(stdout), outbuf, outlen) < 0) {
+		/* Nowhere to report it */
+	}
+	outlen = 0;
+}
+
+static void real_putc(int c)
+{
+	if (outlen == OUTSIZE)
+		real_flush();
+	outbuf[outlen++] = c;
+}
+
+static void real_puts(const char *s)
+{
+	while (*s)
+		real_putc(*s++);
+}
+
+/* Cursor motion sequence with a count: "\033[%dB" etc. */
+
+static void real_move(int n, int dir)
+{
+	char buf[16];
+	snprintf(buf, sizeof(buf), "\033[%d%c", n, dir);
+	real_puts(buf);
+}
+
 /* Set real cursor position */
 
 void cpos(int y, int x)
@@ -48,20 +91,20 @@ void cpos(int y, int x)
 			}
 		} else */
 		if (y - scrn_y == 1) {
-			printf("\033[B");
+			real_puts("\033[B");
 			++scrn_y;
 		} else {
-			printf("\033[%dB", y - scrn_y);
+			real_move(y - scrn_y, 'B');
 			scrn_y += y - scrn_y;
 		}
 	}
 
 	if (y < scrn_y) { /* Need to go up */
 		if (scrn_y - y == 1) {
-			printf("\033[A");
+			real_puts("\033[A");
 			--scrn_y;
 		} else {
-			printf("\033[%dA", scrn_y - y);
+			real_move(scrn_y - y, 'A');
 			scrn_y -= scrn_y - y;
 		}
 	}
@@ -74,25 +117,25 @@ void cpos(int y, int x)
 			}
 		} */
 		if (x - scrn_x == 1) {
-			printf("\033[C");
+			real_puts("\033[C");
 			scrn_x += 1;
 		} else {
-			printf("\033[%dC", x - scrn_x);
+			real_move(x - scrn_x, 'C');
 			scrn_x += x - scrn_x;
 		}
 	}
 
 	if (x < scrn_x) { /* Need to go left */
 		if (x == 0) {
-			putchar(13);
+			real_putc(13);
 			scrn_x = 0;
 		} else if (scrn_x - x <= 4) {
 			while (x < scrn_x) {
-				putchar(8);
+				real_putc(8);
 				--scrn_x;
 			}
 		} else { 
-			printf("\033[%dD", scrn_x - x);
+			real_move(scrn_x - x, 'D');
 			scrn_x -= scrn_x - x;
 		}
 	}
@@ -103,11 +146,11 @@ void cpos(int y, int x)
 void out(int y, int x, int c)
 {
 	cpos(y, x);
-	putchar(c);
+	real_putc(c);
 	scrn[scrn_y * WIDTH + scrn_x] = c;
 	++scrn_x;
 	if (scrn_x == WIDTH) {
-		putchar(13);
+		real_putc(13);
 		scrn_x = 0;
 	}
 }
@@ -117,13 +160,14 @@ void out(int y, int x, int c)
 void izscrn()
 {
 	int y;
-	putchar('\r');
+	real_putc('\r');
 	for (y = 0; y != HEIGHT; ++y) {
 		int x;
 		for (x = 0; x != WIDTH; ++x) {
 			scrn[y*WIDTH + x] = ' ';
 		}
-		putchar('\n');
+		dirty[y] = 1;
+		real_putc('\n');
 	}
 	scrn_x = 0;
 	scrn_y = HEIGHT - 1;
@@ -191,6 +235,7 @@ void term_reset()
 		for (x = 0; x != WIDTH; ++x) {
 			screen[y*WIDTH + x] = ' ';
 		}
+		dirty[y] = 1;
 	}
 	xleft = 0;
 	xright = WIDTH;
@@ -208,6 +253,9 @@ void update()
 	int y;
 	for (y = 0; y != HEIGHT; ++y) {
 		int x;
+		if (!dirty[y])
+			continue;
+		dirty[y] = 0;
 		for (x = 0; x != WIDTH; ++x) {
 			if (scrn[y*WIDTH + x] != screen[y*WIDTH + x]) {
 				out(y, x, screen[y*WIDTH + x]);
@@ -215,7 +263,7 @@ void update()
 		}
 	}
 	cpos(ypos, xpos);
-	fflush(stdout);
+	real_flush();
 }
 
 /* Initialize emulator */
@@ -237,10 +285,12 @@ void del(int line)
 		memcpy(screen + (y - 1) * WIDTH + xleft,
 		       screen + (y    ) * WIDTH + xleft,
 		       (xright - xleft) * sizeof(screen[0]));
+		dirty[y - 1] = 1;
 	}
 	for (x = xleft; x != xright; ++x) {
 		screen[(y - 1) * WIDTH + x] = ' ';
 	}
+	dirty[y - 1] = 1;
 }
 
 /* Insert list in virtual area */
@@ -253,10 +303,12 @@ void ins(int line)
 		memcpy(screen + (y    ) * WIDTH + xleft,
 		       screen + (y - 1) * WIDTH + xleft,
 		       (xright - xleft) * sizeof(screen[0]));
+		dirty[y] = 1;
 	}
 	for (x = xleft; x != xright; ++x) {
 		screen[y * WIDTH + x] = ' ';
 	}
+	dirty[y] = 1;
 }
 
 /* Scroll virtual area up */
@@ -268,11 +320,12 @@ void scrup()
 		int y, x;
 		update();
 		cpos(HEIGHT - 1, 0);
-		putchar(10);
+		real_putc(10);
 		for (y = 1; y != HEIGHT; ++y) {
 			memcpy(scrn + (y - 1) * WIDTH,
 			       scrn + (y    ) * WIDTH,
 			       WIDTH * sizeof(screen[0]));
+			dirty[y - 1] = 1;
 		}
 		for (x = 0; x != WIDTH; ++x) {
 			scrn[(y - 1) * WIDTH + x] = ' ';
@@ -288,11 +341,13 @@ void term_type(int c)
 	switch (mode) {
 		case SCROLL: { /* Scroll */
 			screen[ypos * WIDTH + xpos] = c;
+			dirty[ypos] = 1;
 			if (++xpos == xright)
 				xpos = xright - 1;
 			break;
 		} case PAGE: { /* Page */
 			screen[ypos * WIDTH + xpos] = c;
+			dirty[ypos] = 1;
 			if (++xpos == xright) {
 				xpos = xleft;
 				if (++ypos == ybottom) {
@@ -425,6 +480,7 @@ void term_clear()
 	for (y = ytop; y != ybottom; ++y) {
 		for (x = xleft; x != xright; ++x)
 			screen[y * WIDTH + x] = ' ';
+		dirty[y] = 1;
 	}
 	term_home();
 }
@@ -1073,6 +1129,7 @@ void term_out(int c)
 			state = IDLE;
 			if (c >= 0x20 && c < 0x7F && inbuf[0] >= 0 && inbuf[0] < HEIGHT && inbuf[1] >= 0 && inbuf[1] < WIDTH) {
 				screen[inbuf[0] * WIDTH + inbuf[1]] = c;
+				dirty[inbuf[0]] = 1;
 				++inbuf[1];
 				state = WRITE_ABSOLUTE_4;
 			}
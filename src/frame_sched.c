@@ -0,0 +1,112 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+
+#include "frame_sched.h"
+
+/////////////////////////////
+// Frame scheduler
+//
+// 'owed' is how far (in cycles) the emulation is behind the host clock.  Each
+// frame adds the host time since the last one, and the budget pays off as much
+// of that as fits in FRAME_WORK_MS at the measured host cost per cycle.  What
+// doesn't fit is carried over, so a slow host or a long frame is made up over
+// the next frames.  Browsers throttle background tabs to a frame a second or
+// less; the debt is capped at FRAME_CATCHUP_MS so coming back to the tab
+// doesn't mean a long burst of catching up.
+//
+// Cycles spent in SLP are skipped almost for free, while busy firmware costs
+// the full price, so the two are measured apart: ms_per_cycle is the running
+// average cost of a busy cycle, and busy_share the running average part of
+// the cycles that are busy.  A frame that starts with the CPU awake is
+// budgeted as if every cycle is busy.  One that starts with it asleep only
+// gets FRAME_SLEEP_MS of host time, at busy_share; an idle machine still
+// keeps up with the clock on that, since nearly all of its cycles are
+// skipped.  Switched off, there's nothing to keep up with at all.
+
+#define MS_PER_CYCLE_START  0.0001          // a guess, until we have measured it
+#define BUSY_SHARE_MIN      0.01            // so a burst of work can't blow a frame
+
+static double cycles_per_ms = 1228.8;
+static double ms_per_cycle = MS_PER_CYCLE_START;
+static double busy_share = 1.0;
+static double owed = 0;
+static double last_ms = -1;                 // start of the previous frame
+static double begin_ms = 0;                 // start of this frame
+
+void frame_sched_init(uint32_t clock_hz)
+{
+    cycles_per_ms = clock_hz / 1000.0;
+    ms_per_cycle = MS_PER_CYCLE_START;
+    busy_share = 1.0;
+    owed = 0;
+    last_ms = -1;
+}
+
+uint32_t frame_sched_begin(double now_ms, int state)
+{
+    double max_owed = FRAME_CATCHUP_MS * cycles_per_ms;
+    double affordable = FRAME_WORK_MS / ms_per_cycle;
+    double budget;
+
+    begin_ms = now_ms;
+    if (last_ms >= 0 && now_ms > last_ms) {
+        owed += (now_ms - last_ms) * cycles_per_ms;
+    }
+    last_ms = now_ms;
+
+    if (state == FRAME_OFF) {
+        owed = 0;                           // nothing to catch up with
+        return FRAME_MIN_CYCLES;
+    }
+    if (owed > max_owed) {
+        owed = max_owed;                    // been throttled - let it go
+    }
+    if (state == FRAME_ASLEEP) {
+        double share = busy_share < BUSY_SHARE_MIN ? BUSY_SHARE_MIN : busy_share;
+        affordable = FRAME_SLEEP_MS / (ms_per_cycle * share);
+    }
+    budget = owed < affordable ? owed : affordable;
+    if (budget < 1) {
+        budget = 1;
+    }
+    return (uint32_t) budget;
+}
+
+void frame_sched_end(double now_ms, uint32_t cycles, uint32_t slept)
+{
+    double spent = now_ms - begin_ms;
+    uint32_t busy = (slept < cycles) ? cycles - slept : 0;
+
+    owed -= cycles;
+    if (owed < 0) {
+        owed = 0;                           // sim() can overshoot by an instruction
+    }
+    if (cycles < 100) {
+        return;                             // too few to measure
+    }
+    // exponential averages, 1/8 weight for new samples
+    busy_share += ((double) busy / cycles - busy_share) / 8;
+    if (busy < 100) {
+        return;
+    }
+    if (spent < 0.01) {
+        spent = 0.01;                       // host clock may not have ticked
+    }
+    ms_per_cycle += (spent / busy - ms_per_cycle) / 8;
+}
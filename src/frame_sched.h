@@ -0,0 +1,38 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Cycles-per-frame scheduler for the web version.
+ *
+ * The browser calls us once per animation frame.  frame_sched_begin() says
+ * how many cycles to simulate so the emulation keeps up with the host clock,
+ * without spending so long in one frame that the browser drops frames.
+ * frame_sched_end() measures how long that took.  Times are passed in, so
+ * this is plain C and can be driven by a fake clock.
+ */
+
+#ifndef FRAME_SCHED_H
+#define FRAME_SCHED_H
+
+#include <stdint.h>
+
+#define FRAME_WORK_MS      10.0     // host time we may spend simulating per frame (of 16.7 at 60 Hz)
+#define FRAME_SLEEP_MS     2.0      // the same while the CPU sleeps: skipping SLP is nearly free
+#define FRAME_CATCHUP_MS   250.0    // most emulated time we'll try to make up (after tab throttling)
+#define FRAME_MIN_CYCLES   1000     // budget while the machine is switched off
+
+// What the CPU is doing at the start of a frame
+#define FRAME_AWAKE        0
+#define FRAME_ASLEEP       1        // in SLP, waiting for an interrupt
+#define FRAME_OFF          2        // switched off: nothing wakes it but the power key
+
+void frame_sched_init(uint32_t clock_hz);
+
+// Start of a frame at host time now_ms, with the CPU in 'state' (FRAME_AWAKE
+// etc).  Returns the number of cycles to simulate.
+uint32_t frame_sched_begin(double now_ms, int state);
+
+// End of the frame: 'cycles' were simulated, 'slept' of them skipped in SLP,
+// and it is now now_ms
+void frame_sched_end(double now_ms, uint32_t cycles, uint32_t slept);
+
+#endif
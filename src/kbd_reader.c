@@ -0,0 +1,377 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef WASM
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "kbd_reader.h"
+#include "pacing.h"
+#include "ring.h"
+#include "utils.h"
+#include "workslate.h"
+
+/////////////////////////////
+// Keyboard reader thread
+//
+// The thread owns stdin while the simulation runs, so the emulator never
+// makes a syscall to look at the keyboard.  When the monitor wants stdin, it
+// parks the thread (kbd_reader_pause()), which hands over anything it has
+// read but not parsed yet; kbd_reader_resume() takes back what the monitor
+// didn't use.
+//
+// Events go through a lock-free ring, 4 bytes each.  When the ring is full
+// the thread stops reading, leaving the rest typed ahead in the terminal.
+// Keys that aren't on the WorkSlate go through a second ring, so that the
+// emulator thread reports them and nothing else writes to the terminal.
+// See the key map comment in workslate_hw.c for which key is which.
+
+#define KBD_QUEUE_SIZE   4096              // bytes - 1024 events
+#define KBD_UNKNOWN_SIZE 256               // bytes - 32 unknown keys
+#define KBD_ESC_MSEC     25                // wait this long for the rest of an escape sequence
+
+static uint8_t queue_buf[KBD_QUEUE_SIZE];
+static struct ring queue;
+static uint8_t unknown_buf[KBD_UNKNOWN_SIZE];
+static struct ring unknown;
+static int wake_pipe[2];
+
+static uint8_t in_buf[256];                // bytes read from stdin, not parsed yet
+static int in_len = 0, in_pos = 0;
+
+static pthread_mutex_t park_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t park_cond = PTHREAD_COND_INITIALIZER;
+static int park_pipe[2];                   // wakes the thread up to park
+static int park_wanted = 0;
+static int parked = 0;
+static int running = 0;                    // thread hasn't hit end of file
+
+static void wake_emulator(void)
+{
+    char c = 0;
+
+    if (write(wake_pipe[1], &c, 1) < 0) {
+        // pipe already full, so a wakeup is pending anyway
+    }
+}
+
+// If the monitor wants stdin, hand over the unparsed input and wait until
+// it is done
+static void park_if_wanted(void)
+{
+    pthread_mutex_lock(&park_lock);
+    if (park_wanted) {
+        unread_stdin((char *) in_buf + in_pos, in_len - in_pos);
+        in_pos = in_len = 0;
+        parked = 1;
+        pthread_cond_broadcast(&park_cond);
+        while (park_wanted) {
+            pthread_cond_wait(&park_cond, &park_lock);
+        }
+        parked = 0;
+        in_len = take_unread_stdin((char *) in_buf, sizeof(in_buf));
+    }
+    pthread_mutex_unlock(&park_lock);
+}
+
+static void queue_event(uint32_t event)
+{
+    while (ring_space(&queue) < sizeof(event)) {
+        poll(NULL, 0, 10);                  // emulator is behind - wait for it
+        park_if_wanted();                   // (it may be in the monitor)
+    }
+    ring_write(&queue, &event, sizeof(event));
+    wake_emulator();
+}
+
+// Next byte from stdin.  Returns -1 if none comes within timeout_ms (or
+// the monitor wants stdin), -2 at end of file
+static int next_byte(int timeout_ms)
+{
+    struct pollfd p[2];
+    char junk[16];
+    ssize_t n;
+
+    if (in_pos == in_len) {
+        p[0].fd = fileno(stdin);
+        p[0].events = POLLIN;
+        p[1].fd = park_pipe[0];
+        p[1].events = POLLIN;
+        if (poll(p, 2, timeout_ms) <= 0) {
+            return -1;
+        }
+        if (p[1].revents & POLLIN) {
+            while (read(park_pipe[0], junk, sizeof(junk)) > 0)
+                ;
+            return -1;
+        }
+        n = read(fileno(stdin), in_buf, sizeof(in_buf));
+        if (n <= 0) {
+            return (n == 0) ? -2 : -1;
+        }
+        in_len = n;
+        in_pos = 0;
+    }
+    return in_buf[in_pos++];
+}
+
+// Turn one key (a character, or a whole escape sequence) into matrix events
+static void key_events(uint64_t inkey)
+{
+    int shift_key = 0;
+    int special_key = 0;
+    if ((inkey >= 'A') && (inkey <= 'Z')) {
+        inkey = inkey - 'A' + 'a';
+        shift_key = 1;
+    }
+
+    uint32_t f = 0;
+    switch(inkey) {
+        case 'a': f = 0x0110; break;
+        case 'b': f = 0x1080; break;
+        case 'g'-0x60: f = 0x1080; special_key = 1; break;  // special-B --> Get
+        case 'c': f = 0x0480; break;
+//      case ???: f = 0x0480; special_key = 1; break;  // special-C = CT char (displays as 0x1c)
+        case 'd': f = 0x0410; break;
+        case 'e': f = 0x0401; break;
+        case '#': f = 0x0401; special_key = 1; break;  // special-E
+        case 'f': f = 0x0810; break;
+        case '\\':f = 0x0810; special_key = 1; break;  // special-F
+        case 'g': f = 0x1010; break;
+        case '^': f = 0x1010; special_key = 1; break;  // special-G
+        case 'h': f = 0x2010; break;
+        case '_': f = 0x2010; special_key = 1; break;  // special-H
+        case 'i': f = 0x8001; break;
+     // case    : f = 0x8001; special_key = 1; break;  // special-I  This shows as a '-', same as the subtract!
+        case 'j': f = 0x4010; break;
+        case '|': f = 0x4010; special_key = 1; break;  // special-J
+        case 'k': f = 0x8010; break;
+        case '~': f = 0x8010; special_key = 1; break;  // special-K
+        case 'l': f = 0x8004; break;
+//      case ???: f = 0x8004; special_key = 1; break;  // special-L is a big solid box
+        case 'm': f = 0x4080; break;
+        case 'w'-0x60: f = 0x4080; special_key = 1; break;  // special-M--> Switch
+        case 'n': f = 0x2080; break;
+        case 'r'-0x60: f = 0x2080; special_key = 1; break;  // special-N --> Recalc
+        case 'o': f = 0x8002; break;
+        case '?': f = 0x8002; special_key = 1; break;  // special-O
+        case 'p': f = 0x4002; break;
+        case 'd'-0x60: f = 0x4002; special_key = 1; break;  // special-P -- actually '/' but we map that to divide
+        case 'q': f = 0x0101; break;
+        case '!': f = 0x0101; special_key = 1; break;  // special-Q
+        case 'r': f = 0x0801; break;
+        case '&': f = 0x0801; special_key = 1; break;  // special-R
+        case 's': f = 0x0210; break;
+        case '`': f = 0x0210; special_key = 1; break;  // special-S
+        case 't': f = 0x1001; break;
+        case 'a'-0x60: f = 0x1001; special_key = 1; break;  // special-T -- actually '*' but we map that to times
+        case 'u': f = 0x4001; break;
+        case '\"':f = 0x4001; special_key = 1; break;  // special-U
+        case 'v': f = 0x0880; break;
+        case 's'-0x60: f = 0x0880; special_key = 1; break;  // special-V --> Save
+        case 'w': f = 0x0201; break;
+        case '@': f = 0x0201; special_key = 1; break;  // special-W
+        case 'x': f = 0x0280; break;
+        case 'p'-0x60: f = 0x0280; special_key = 1; break;  // special-X --> Print
+        case 'y': f = 0x2001; break;
+        case '\'':f = 0x2001; special_key = 1; break;  // special-Y
+        case 'z': f = 0x0180; break;
+        case 'f'-0x60: f = 0x0180; special_key = 1; break;  // special-Z --> Find
+        case '0': f = 0x8040; break;
+        case '<': f = 0x8040; special_key = 1; break;  // special-0
+        case '1': f = 0x0140; break;
+        case '[': f = 0x0140; special_key = 1; break;  // special-1
+        case '2': f = 0x0240; break;
+        case ']': f = 0x0240; special_key = 1; break;  // special-2
+        case '3': f = 0x0440; break;
+        case 'n'-0x60: f = 0x0440; special_key = 1; break;  // special 3 -- not equals
+        case '4': f = 0x1004; break;
+        case '(': f = 0x1004; special_key = 1; break;  // special-4
+        case '5': f = 0x0804; break;
+        case ')': f = 0x0804; special_key = 1; break;  // special-5
+        case '6': f = 0x0404; break;
+        case '%': f = 0x0404; special_key = 1; break;  // special-6
+        case '7': f = 0x1002; break;
+        case '{': f = 0x1002; special_key = 1; break;  // special-7
+        case '8': f = 0x0102; break;
+        case '}': f = 0x0102; special_key = 1; break;  // special-8
+        case '9': f = 0x0202; break;
+        case '$': f = 0x0202; special_key = 1; break;  // special-9
+        case ',': f = 0x8080; break;                   // (near letters not numpad) not in chart
+        case ';': f = 0x8080; special_key = 1; break;  // special , ERROR: returns ,,,,,,,
+        case '.': f = 0x4040; break;  // numpad
+    // ^^ SAW SOMETHING ODD IN MEMO ONCE
+        case '>': f = 0x4040; special_key = 1; break;  // special-.
+        //            0x2004;         // duplicate '.' key next to L  -- we don't use
+        case ':': f = 0x2004; special_key = 1; break; // ERROR: returns ....
+        case '=': f = 0x2040; break;  // aka "Formula"
+    // ^^ SAW SOMETHING ODD IN MEMO ONCE
+        case '+': f = 0x1040; break;
+        case '-': f = 0x0840; break;
+        case '/': f = 0x0802; break;  // divide character
+        case '*': f = 0x0402; break;  // multiply character
+        case ' ': f = 0x0420; break;  // space bar
+        case 0x0D:f = 0x0820; break;  // Enter-->DoIt
+        case 0x7F:f = 0x2002; break;  // backspace
+        case 0x1b:f = 0x0208; break;  // ESC --->Cancel
+        case 0x1b5b41:f = 0x1020; break;  // up
+        case 0x1b5b42:f = 0x8020; break;  // down
+        case 0x1b5b43:f = 0x2020; break;  // right
+        case 0x1b5b44:f = 0x4020; break;  // left
+        case     0x1b4f50:f = 0x0408; break;  // F1 -->    Calc soft key
+        case     0x1b4f51:f = 0x0808; break;  // F2 --> Finance soft key
+        case     0x1b4f52:f = 0x1008; break;  // F3 -->    Memo soft key
+        case     0x1b4f53:f = 0x4008; break;  // F4 -->   Phone soft key
+        case 0x1b5b31357e:f = 0x2008; break;  // F5 -->    Time soft key
+
+        case 0x1b5b31377e:f = 0x8008; break;  // F6 -->      Options key
+        case 0x1b5b31387e:f = 0x0120; break;  // F7 -->    Worksheet key
+        case 0x1b5b31397e:f = KBD_POWER; break;  // F8 --> Power key
+        // "Special" key is       0220 but it acts like a shift key
+        default:
+            if (ring_space(&unknown) >= sizeof(inkey)) {
+                ring_write(&unknown, &inkey, sizeof(inkey));   // reported by the emulator
+                wake_emulator();
+            }
+    }
+    if (shift_key) {
+        queue_event(KBD_SHIFT);     // shift goes down first
+    }
+    if (special_key) {
+        queue_event(KBD_SPECIAL);
+    }
+    if (f) {
+        queue_event(f);
+    }
+    queue_event(KBD_RELEASE);       // then let go of everything
+}
+
+static void *kbd_thread(void *arg)
+{
+    uint64_t inkey;
+    int c, len;
+
+    for (;;) {
+        park_if_wanted();
+        c = next_byte(-1);
+        if (c == -2) {
+            pthread_mutex_lock(&park_lock);
+            running = 0;                    // end of file
+            pthread_cond_broadcast(&park_cond);
+            pthread_mutex_unlock(&park_lock);
+            return NULL;
+        }
+        if (c < 0) {
+            continue;
+        }
+
+        inkey = c;
+        if (c == 0x1b && (c = next_byte(KBD_ESC_MSEC)) >= 0) {
+            // ESC [ params final, or ESC O x.  Otherwise just ESC x
+            inkey = (inkey << 8) | c;
+            len = 2;
+            if (c == '[' || c == 'O') {
+                int more = (c == '[');
+                while (len < 8 && (c = next_byte(KBD_ESC_MSEC)) >= 0) {
+                    inkey = (inkey << 8) | c;
+                    len++;
+                    if (!more || c >= 0x40) {
+                        break;               // final byte
+                    }
+                }
+            }
+        }
+        key_events(inkey);
+    }
+    return NULL;
+}
+
+int kbd_reader_start(void)
+{
+    pthread_t thread;
+
+    ring_init(&queue, queue_buf, KBD_QUEUE_SIZE);
+    ring_init(&unknown, unknown_buf, KBD_UNKNOWN_SIZE);
+    if (pipe(wake_pipe) || pipe(park_pipe)) {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    fcntl(park_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(park_pipe[1], F_SETFL, O_NONBLOCK);
+    running = 1;
+    if (pthread_create(&thread, NULL, kbd_thread, NULL)) {
+        printf("Can't start keyboard thread\n");
+        running = 0;
+        return -1;
+    }
+    pthread_detach(thread);
+    pacing_set_wake_fd(wake_pipe[0]);
+    return 0;
+}
+
+void kbd_reader_pause(void)
+{
+    char c = 0;
+
+    pthread_mutex_lock(&park_lock);
+    park_wanted = 1;
+    if (write(park_pipe[1], &c, 1) < 0) {
+        // already full: the thread has a wakeup waiting
+    }
+    while (running && !parked) {
+        pthread_cond_wait(&park_cond, &park_lock);
+    }
+    pthread_mutex_unlock(&park_lock);
+}
+
+void kbd_reader_resume(void)
+{
+    pthread_mutex_lock(&park_lock);
+    park_wanted = 0;
+    pthread_cond_broadcast(&park_cond);
+    pthread_mutex_unlock(&park_lock);
+}
+
+int kbd_reader_unknown(uint64_t *key)
+{
+    if (ring_count(&unknown) < sizeof(*key)) {
+        return 0;
+    }
+    ring_peek(&unknown, key, sizeof(*key));
+    ring_drop(&unknown, sizeof(*key));
+    return 1;
+}
+
+int kbd_reader_get(uint32_t *event)
+{
+    if (ring_count(&queue) < sizeof(*event)) {
+        return 0;
+    }
+    ring_peek(&queue, event, sizeof(*event));
+    ring_drop(&queue, sizeof(*event));
+    return 1;
+}
+#endif // WASM
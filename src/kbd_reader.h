@@ -0,0 +1,26 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Keyboard reader thread (terminal version only).
+ *
+ * Reads the terminal, turns keys and escape sequences into keyboard matrix
+ * events (kbd_event() words, see workslate.h), and queues them for the
+ * emulator.  Each new event also writes to a pipe, which pacing.c watches so
+ * that typing wakes up an idle CPU.
+ */
+
+#ifndef KBD_READER_H
+#define KBD_READER_H
+
+#include <stdint.h>
+
+int kbd_reader_start(void);              // -1 on error
+int kbd_reader_get(uint32_t *event);     // returns 0 if the queue is empty
+int kbd_reader_unknown(uint64_t *key);   // a key the WorkSlate doesn't have.  0 if none
+
+// For the monitor: stop reading stdin (what was read ahead goes to
+// jgetline()), and start again.  Only call these from the emulator thread.
+void kbd_reader_pause(void);
+void kbd_reader_resume(void);
+
+#endif
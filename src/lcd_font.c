@@ -0,0 +1,241 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+
+#include "lcd_font.h"
+
+/////////////////////////////
+// Character generator
+//
+// 6 columns per character, each a byte with the top pixel in the LSB.  Bit 7
+// of a character code means inverse.  See the LCD section of workslate_hw.c
+// for what is known about the real character generator.
+
+// Font.  LSB=top.   A space before the first tab means it's been visually checked vs. workslate
+const uint8_t lcd_font[128][6] = {
+ 	{ 0x10, 0x38, 0x54, 0x10, 0x10, 0x10 },  // 00   0  ←
+ 	{ 0x10, 0x10, 0x10, 0x54, 0x38, 0x10 },  // 01   1  →
+ 	{ 0x00, 0x7F, 0x41, 0x55, 0x41, 0x7F },  // 02   2  ✇ (square tape)
+ 	{ 0x00, 0x02, 0x55, 0x7d, 0x02, 0x00 },  // 03   3  ⚿ key
+ 	{ 0x00, 0x22, 0x14, 0x08, 0x14, 0x22 },  // 04   4  ×
+ 	{ 0x00, 0x08, 0x08, 0x2A, 0x08, 0x08 },  // 05   5  ÷
+ 	{ 0x00, 0x54, 0x34, 0x1C, 0x16, 0x15 },  // 06   6  ≠
+ 	{ 0x00, 0x20, 0x38, 0x7C, 0x38, 0x20 },  // 07   7 🔔
+ 	{ 0x00, 0x7e, 0xff, 0xe7, 0xe7, 0x00 },  // 08   8 📞
+ 	{ 0x3E, 0x41, 0x4F, 0x51, 0x61, 0x3E },  // 09   9  ◷
+ 	{ 0x00, 0x0F, 0x08, 0xF8, 0x50, 0x10 },  // 0A  10  ␊
+ 	{ 0x00, 0x08, 0x1C, 0x3E, 0x7F, 0x00 },  // 0B  11  ◀
+ 	{ 0x00, 0x1F, 0x05, 0xF9, 0x28, 0x08 },  // 0C  12  ␌
+ 	{ 0x00, 0x0F, 0x09, 0xF9, 0x50, 0xA0 },  // 0D  13  ␍
+ 	{ 0x00, 0x00, 0xF8, 0xF8, 0x18, 0x18 },  // 0E  14  ┏
+ 	{ 0x18, 0x18, 0xF8, 0xF8, 0x00, 0x00 },  // 0F  15  ┓
+ 	{ 0x00, 0x00, 0x1F, 0x1F, 0x18, 0x18 },  // 10  16  ┗
+ 	{ 0x18, 0x18, 0x1F, 0x1F, 0x00, 0x00 },  // 11  17  ┛
+ 	{ 0x18, 0x18, 0xFF, 0xFF, 0x18, 0x18 },  // 12  18  ╋
+ 	{ 0x18, 0x18, 0xF8, 0xF8, 0x18, 0x18 },  // 13  19  ┳
+ 	{ 0x18, 0x18, 0x1F, 0x1F, 0x18, 0x18 },  // 14  20  ┻
+ 	{ 0x00, 0x00, 0xFF, 0xFF, 0x18, 0x18 },  // 15  21  ┣
+ 	{ 0x18, 0x18, 0xFF, 0xFF, 0x00, 0x00 },  // 16  22  ┫
+ 	{ 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00 },  // 17  23  ┃
+ 	{ 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 },  // 18  24  ━
+	{ 0x14, 0x14, 0x14, 0x14, 0x14, 0x14 },  // 19  25  ═
+	{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF },  // 1A  26  ▣
+	{ 0x00, 0x1F, 0x15, 0xF1, 0xA0, 0xA0 },  // 1B  27  ␛
+ 	{ 0x00, 0x0F, 0x09, 0x19, 0xF0, 0x10 },  // 1C  28  CT
+	{ 0xFF, 0xF1, 0xF1, 0xF1, 0xF1, 0xFF },  // 1D  29  ⬓
+	{ 0xFF, 0x81, 0x81, 0xFF, 0xFF, 0xFF },  // 1E  30  ◨
+	{ 0x7F, 0x41, 0x41, 0x41, 0x41, 0x7F },  // 1F  31  ▢
+ 	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // 20  32
+ 	{ 0x00, 0x00, 0x00, 0x4F, 0x00, 0x00 },  // 21  33  !
+ 	{ 0x00, 0x00, 0x07, 0x00, 0x07, 0x00 },  // 22  34  "
+ 	{ 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14 },  // 23  35  #
+ 	{ 0x00, 0x24, 0x2A, 0x7F, 0x2A, 0x12 },  // 24  36  $
+ 	{ 0x00, 0x63, 0x13, 0x08, 0x64, 0x63 },  // 25  37  %
+ 	{ 0x00, 0x36, 0x49, 0x55, 0x22, 0x50 },  // 26  38  &
+ 	{ 0x00, 0x00, 0x05, 0x03, 0x00, 0x00 },  // 27  39  '
+ 	{ 0x00, 0x00, 0x1C, 0x22, 0x41, 0x00 },  // 28  40  (
+ 	{ 0x00, 0x00, 0x41, 0x22, 0x1C, 0x00 },  // 29  41  )
+ 	{ 0x00, 0x14, 0x08, 0x3E, 0x08, 0x14 },  // 2A  42  *
+	{ 0x00, 0x08, 0x08, 0x3E, 0x08, 0x08 },  // 2B  43  +
+	{ 0x00, 0x00, 0x50, 0x30, 0x00, 0x00 },  // 2C  44  ,
+ 	{ 0x00, 0x08, 0x08, 0x08, 0x08, 0x08 },  // 2D  45  -
+	{ 0x00, 0x00, 0x60, 0x60, 0x00, 0x00 },  // 2E  46  .
+ 	{ 0x00, 0x40, 0x20, 0x10, 0x08, 0x04 },  // 2F  47  /
+	{ 0x00, 0x3E, 0x51, 0x49, 0x45, 0x3E },  // 30  48  0
+ 	{ 0x00, 0x00, 0x42, 0x7F, 0x40, 0x00 },  // 31  49  1
+ 	{ 0x00, 0x42, 0x61, 0x51, 0x49, 0x46 },  // 32  50  2
+ 	{ 0x00, 0x21, 0x41, 0x45, 0x4B, 0x31 },  // 33  51  3
+ 	{ 0x00, 0x18, 0x14, 0x12, 0x7F, 0x10 },  // 34  52  4
+ 	{ 0x00, 0x27, 0x45, 0x45, 0x45, 0x39 },  // 35  53  5
+ 	{ 0x00, 0x3C, 0x4A, 0x49, 0x49, 0x30 },  // 36  54  6
+ 	{ 0x00, 0x01, 0x71, 0x09, 0x05, 0x03 },  // 37  55  7
+ 	{ 0x00, 0x36, 0x49, 0x49, 0x49, 0x36 },  // 38  56  8
+ 	{ 0x00, 0x06, 0x49, 0x49, 0x29, 0x1E },  // 39  57  9
+	{ 0x00, 0x00, 0x36, 0x36, 0x00, 0x00 },  // 3A  58  :
+	{ 0x00, 0x00, 0x56, 0x36, 0x00, 0x00 },  // 3B  59  ;
+ 	{ 0x00, 0x08, 0x14, 0x22, 0x41, 0x00 },  // 3C  60  <
+	{ 0x00, 0x14, 0x14, 0x14, 0x14, 0x14 },  // 3D  61  =
+ 	{ 0x00, 0x00, 0x41, 0x22, 0x14, 0x08 },  // 3E  62  >
+ 	{ 0x00, 0x02, 0x01, 0x51, 0x09, 0x06 },  // 3F  63  ?
+ 	{ 0x00, 0x3E, 0x41, 0x5D, 0x55, 0x1E },  // 40  64  @
+	{ 0x00, 0x7E, 0x09, 0x09, 0x09, 0x7E },  // 41  65  A
+	{ 0x00, 0x7F, 0x49, 0x49, 0x49, 0x36 },  // 42  66  B
+	{ 0x00, 0x3E, 0x41, 0x41, 0x41, 0x22 },  // 43  67  C
+	{ 0x00, 0x7F, 0x41, 0x41, 0x22, 0x1C },  // 44  68  D
+	{ 0x00, 0x7F, 0x49, 0x49, 0x49, 0x41 },  // 45  69  E
+	{ 0x00, 0x7F, 0x09, 0x09, 0x09, 0x01 },  // 46  70  F
+	{ 0x00, 0x3E, 0x41, 0x49, 0x49, 0x7A },  // 47  71  G
+	{ 0x00, 0x7F, 0x08, 0x08, 0x08, 0x7F },  // 48  72  H
+	{ 0x00, 0x00, 0x41, 0x7F, 0x41, 0x00 },  // 49  73  I
+	{ 0x00, 0x20, 0x40, 0x41, 0x3F, 0x01 },  // 4A  74  J
+	{ 0x00, 0x7F, 0x08, 0x14, 0x22, 0x41 },  // 4B  75  K
+	{ 0x00, 0x7F, 0x40, 0x40, 0x40, 0x40 },  // 4C  76  L
+	{ 0x00, 0x7F, 0x02, 0x0C, 0x02, 0x7F },  // 4D  77  M
+	{ 0x00, 0x7F, 0x04, 0x08, 0x10, 0x7F },  // 4E  78  N
+	{ 0x00, 0x3E, 0x41, 0x41, 0x41, 0x3E },  // 4F  79  O
+	{ 0x00, 0x7F, 0x09, 0x09, 0x09, 0x06 },  // 50  80  P
+	{ 0x00, 0x3E, 0x41, 0x51, 0x21, 0x5E },  // 51  81  Q
+	{ 0x00, 0x7F, 0x09, 0x19, 0x29, 0x46 },  // 52  82  R
+	{ 0x00, 0x46, 0x49, 0x49, 0x49, 0x31 },  // 53  83  S
+	{ 0x00, 0x01, 0x01, 0x7F, 0x01, 0x01 },  // 54  84  T
+	{ 0x00, 0x3F, 0x40, 0x40, 0x40, 0x3F },  // 55  85  U
+	{ 0x00, 0x1F, 0x20, 0x40, 0x20, 0x1F },  // 56  86  V
+	{ 0x00, 0x3F, 0x40, 0x38, 0x40, 0x3F },  // 57  87  W
+	{ 0x00, 0x63, 0x14, 0x08, 0x14, 0x63 },  // 58  88  X
+	{ 0x00, 0x07, 0x08, 0x70, 0x08, 0x07 },  // 59  89  Y
+	{ 0x00, 0x61, 0x51, 0x49, 0x45, 0x43 },  // 5A  90  Z
+ 	{ 0x00, 0x00, 0x7F, 0x41, 0x41, 0x00 },  // 5B  91  [
+ 	{ 0x00, 0x02, 0x04, 0x08, 0x10, 0x20 },  // 5C  92  '\'
+ 	{ 0x00, 0x00, 0x41, 0x41, 0x7F, 0x00 },  // 5D  93  ]
+ 	{ 0x00, 0x04, 0x02, 0x01, 0x02, 0x04 },  // 5E  94  ^
+ 	{ 0x40, 0x40, 0x40, 0x40, 0x40, 0x40 },  // 5F  95  _
+ 	{ 0x00, 0x00, 0x03, 0x05, 0x00, 0x00 },  // 60  96  `
+ 	{ 0x00, 0x20, 0x54, 0x54, 0x54, 0x78 },  // 61  97  a
+ 	{ 0x00, 0x7F, 0x44, 0x44, 0x44, 0x38 },  // 62  98  b
+ 	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x00 },  // 63  99  c
+ 	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x7F },  // 64 100  d
+ 	{ 0x00, 0x38, 0x54, 0x54, 0x54, 0x18 },  // 65 101  e
+ 	{ 0x00, 0x08, 0x7E, 0x09, 0x01, 0x02 },  // 66 102  f
+ 	{ 0x00, 0x18, 0xA4, 0xA4, 0xA4, 0x7C },  // 67 103  g
+ 	{ 0x00, 0x7F, 0x08, 0x04, 0x04, 0x78 },  // 68 104  h
+ 	{ 0x00, 0x00, 0x44, 0x7D, 0x40, 0x00 },  // 69 105  i
+ 	{ 0x00, 0x40, 0x80, 0x88, 0x7A, 0x00 },  // 6A 106  j
+ 	{ 0x00, 0x7F, 0x10, 0x28, 0x44, 0x00 },  // 6B 107  k
+ 	{ 0x00, 0x00, 0x41, 0x7F, 0x40, 0x00 },  // 6C 108  l
+ 	{ 0x00, 0x7C, 0x04, 0x18, 0x04, 0x7C },  // 6D 109  m
+	{ 0x00, 0x7C, 0x08, 0x04, 0x04, 0x78 },  // 6E 110  n
+	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x38 },  // 6F 111  o
+ 	{ 0x00, 0xFC, 0x24, 0x24, 0x24, 0x18 },  // 70 112  p
+ 	{ 0x00, 0x18, 0x24, 0x24, 0x28, 0xFC },  // 71 113  q
+ 	{ 0x00, 0x7C, 0x08, 0x04, 0x04, 0x08 },  // 72 114  r
+ 	{ 0x00, 0x48, 0x54, 0x54, 0x54, 0x24 },  // 73 115  s
+ 	{ 0x00, 0x04, 0x3F, 0x44, 0x40, 0x20 },  // 74 116  t
+ 	{ 0x00, 0x3C, 0x40, 0x40, 0x20, 0x7C },  // 75 117  u
+ 	{ 0x00, 0x1C, 0x20, 0x40, 0x20, 0x1C },  // 76 118  v
+ 	{ 0x00, 0x3C, 0x40, 0x30, 0x40, 0x3C },  // 77 119  w
+ 	{ 0x00, 0x44, 0x28, 0x10, 0x28, 0x44 },  // 78 120  x
+ 	{ 0x00, 0x1C, 0xA0, 0xA0, 0xA0, 0x7C },  // 79 121  y
+ 	{ 0x00, 0x44, 0x64, 0x54, 0x4C, 0x44 },  // 7A 122  z
+ 	{ 0x00, 0x00, 0x08, 0x36, 0x41, 0x00 },  // 7B 123  {
+ 	{ 0x00, 0x00, 0x00, 0x77, 0x00, 0x00 },  // 7C 124  |
+ 	{ 0x00, 0x00, 0x41, 0x36, 0x08, 0x00 },  // 7D 125  }
+ 	{ 0x00, 0x04, 0x02, 0x04, 0x08, 0x04 },  // 7E 126  ~
+ 	{ 0x00, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F }   // 7F 127 typed with Special-L
+};
+
+/////////////////////////////
+// Terminal font
+//
+// The terminal can't show the LCD's own symbols, so characters 00-1f are
+// shown as the closest Unicode characters (UTF-8, most significant byte
+// first).  See the LCD section of workslate_hw.c for where they're used.
+
+uint32_t iso_font[32] = {
+/* 00 */  0xe28690,   // ←  e2 86 90  left arrow
+/* 01 */  0xe28692,   // →  e2 86 92  right arrow (seen in sort)
+/* 02 */  0xe29c87,   // ✇  E2 9C 87  tape symbol (should be squarer)
+/* 03 */  0xE29ABF,   // ⚿  E2 9A BF  key symbol
+/* 04 */  0xc397,     // ×  C3 97     times
+/* 05 */  0xc3b7,     // ÷  C3 B7     divide
+/* 06 */  0xe289a0,   // ≠  e2 89 a0  not equals
+/* 07 */  0xF09F9494, // 🔔 F0 9F 94 94 bell character used for alarms (no unicode)
+// 08     0xF09F939E, // 📞 F0 9F 93 9E phone hook symbol seen in status bar
+/* 08 */  0xe2988e,   // ☎  E2 98 8E  phone hook symbol seen in status bar
+/* 09 */  0xe297b7,   // ◷  e2 97 b7  clock symbol when timer is running
+/* 0a */  0xe2908a,   // ␊  e2 90 8a  displayed by password function
+/* 0b */  0xe29780,   // ◀  e2 97 80  filled arrow next to Row and Column indicators
+/* 0c */  0xe2908c,   // ␌  e2 90 8c  FF character
+/* 0d */  0xe2908d,   // ␍  e2 90 8d  displayed by password function
+/* 0e */  0xe2948f,   // ┏  e2 94 8f
+/* 0f */  0xe29493,   // ┓  e2 94 93
+/* 10 */  0xe29497,   // ┗  e2 94 97
+/* 11 */  0xe2949b,   // ┛  e2 94 9b
+/* 12 */  0xe2958b,   // ╋  e2 95 8b  plus
+/* 13 */  0xe294b3,   // ┳  e2 94 b3  T at top of bars
+/* 14 */  0xe294bb,   // ┻  e2 94 bb  upside down T
+/* 15 */  0xe294a3,   // ┣  e2 94 a3
+/* 16 */  0xe294ab,   // ┫  e2 94 ab
+/* 17 */  0xe29483,   // ┃  e2 94 83  thick vertical bar
+/* 18 */  0xe29481,   // ━  e2 94 81  thick horizontal bar
+/* 19 */  0xe29590,   // ═  e2 95 90
+/* 1a */  0xe296a3,   // ▣  e2 96 a3        ◾  e2 97 be -- not working
+/* 1b */  0xe2909b,   // ␛  e2 90 9b  EC character
+/* 1c */  0xc2a9,     // ©  c2 a9  ... this char actually doesn't exist anywhere else!
+                      // special-C = CT char (displays as 0x1c) ... convergent technologies?!
+                      // This is a C in the top left corner, a T in the bottom right.
+                      // also: ␍  e2 90 8d
+/* 1d */  0xe2ac93,   // ⬓  e2 ac 93  Square with bottom half black (Unicode: 0x2b13)
+/* 1e */  0xe297a8,   // ◨  e2 97 a8  Box with filled right  (these 2 seen in WINDOW)
+/* 1f */  0xe296a2};  // ▢  e2 96 a2
+
+
+/////////////////////////////
+// Glyph atlas
+//
+// All 256 glyphs (normal, then inverse) as an image, LCD_ATLAS_COLS to a row,
+// each LCD pixel LCD_ATLAS_SCALE image pixels square.  The lit part of a pixel
+// is one image pixel smaller than that, and the gap shows the background, so
+// the atlas has the LCD's dot pattern when the browser scales it down.
+// A renderer builds the atlas once and then copies one glyph per character.
+
+uint32_t lcd_atlas_pixel(int x, int y)
+{
+    int glyph = (y / LCD_ATLAS_GLYPH_HEIGHT) * LCD_ATLAS_COLS + x / LCD_ATLAS_GLYPH_WIDTH;
+    int px = (x % LCD_ATLAS_GLYPH_WIDTH) / LCD_ATLAS_SCALE;
+    int py = (y % LCD_ATLAS_GLYPH_HEIGHT) / LCD_ATLAS_SCALE;
+    int inverse = glyph & 0x80;
+    int lit = (lcd_font[glyph & 0x7f][px] >> py) & 1;
+
+    if (x % LCD_ATLAS_SCALE == LCD_ATLAS_SCALE - 1 || y % LCD_ATLAS_SCALE == LCD_ATLAS_SCALE - 1) {
+        return inverse ? LCD_RGB_ON : LCD_RGB_OFF;   // gap between pixels
+    }
+    return (lit ^ !!inverse) ? LCD_RGB_ON : LCD_RGB_OFF;
+}
+
+void lcd_atlas_build(uint8_t *rgba)
+{
+    for (int y = 0; y < LCD_ATLAS_HEIGHT; y++) {
+        for (int x = 0; x < LCD_ATLAS_WIDTH; x++) {
+            uint32_t rgb = lcd_atlas_pixel(x, y);
+            *rgba++ = rgb >> 16;
+            *rgba++ = rgb >> 8;
+            *rgba++ = rgb;
+            *rgba++ = 0xFF;
+        }
+    }
+}
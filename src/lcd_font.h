@@ -0,0 +1,41 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * LCD font and glyph atlas.
+ *
+ * Plain C with no I/O, so the same code builds the glyph images for the web
+ * version and for anything else that wants to draw the screen.
+ */
+
+#ifndef LCD_FONT_H
+#define LCD_FONT_H
+
+#include <stdint.h>
+
+#define LCD_CHAR_WIDTH          6
+#define LCD_CHAR_HEIGHT         8
+
+extern const uint8_t lcd_font[128][LCD_CHAR_WIDTH];   // LSB=top
+extern uint32_t iso_font[32];     // UTF-8 stand-ins for 00-1f on a terminal
+
+#define LCD_RGB_ON              0x000000      // black
+#define LCD_RGB_OFF             0x008000      // CSS "green"
+
+#define LCD_ATLAS_SCALE         10            // image pixels per LCD pixel
+#define LCD_ATLAS_COLS          16            // glyphs per row
+#define LCD_ATLAS_GLYPH_WIDTH   (LCD_CHAR_WIDTH * LCD_ATLAS_SCALE)
+#define LCD_ATLAS_GLYPH_HEIGHT  (LCD_CHAR_HEIGHT * LCD_ATLAS_SCALE)
+#define LCD_ATLAS_WIDTH         (LCD_ATLAS_COLS * LCD_ATLAS_GLYPH_WIDTH)
+#define LCD_ATLAS_HEIGHT        (256 / LCD_ATLAS_COLS * LCD_ATLAS_GLYPH_HEIGHT)
+
+// Colour (0xRRGGBB) of one pixel of the atlas
+uint32_t lcd_atlas_pixel(int x, int y);
+
+// Whole atlas, LCD_ATLAS_WIDTH * LCD_ATLAS_HEIGHT * 4 bytes of RGBA
+void lcd_atlas_build(uint8_t *rgba);
+
+// Where the glyph for a character code (bit 7 = inverse) is in the atlas
+#define LCD_ATLAS_X(data)       (((uint8_t) (data) % LCD_ATLAS_COLS) * LCD_ATLAS_GLYPH_WIDTH)
+#define LCD_ATLAS_Y(data)       (((uint8_t) (data) / LCD_ATLAS_COLS) * LCD_ATLAS_GLYPH_HEIGHT)
+
+#endif
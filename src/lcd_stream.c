@@ -0,0 +1,331 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lcd_stream.h"
+
+int lcd_stream_on = 0;
+
+#ifndef WASM
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "lcdrec.h"
+
+/////////////////////////////
+// LCD stream server
+//
+// The emulator puts each frame in 'latest'; it only ever tries the lock, so
+// if the thread happens to be copying, that frame is skipped and the next
+// one carries the change.  On each tick the thread diffs the latest frame
+// against what each viewer was last sent.  A viewer still working through
+// its last update is left out of the tick; its next diff covers both.  If
+// most of the screen changed, the whole screen is sent instead of a diff.
+
+#define OUT_SIZE   2048      // bigger than a whole-screen update
+
+struct screen {
+    uint64_t cycle;
+    uint8_t cells[LCDREC_CELLS];
+    uint16_t cursor;
+    uint8_t mode;
+};
+
+struct client {
+    int fd;                  // -1 = free slot
+    int started;             // has had the header and the first screen
+    struct screen shown;     // as of the last update
+    uint8_t out[OUT_SIZE];
+    uint32_t out_len;
+    uint32_t out_sent;
+};
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static struct screen latest;           // from the emulator, under lock
+static int latest_new = 0;
+
+static struct client clients[LCD_STREAM_CLIENTS];
+static int listen_fd = -1;
+static uint32_t clock_hz;
+static double tick_ms;
+
+static double now_ms(void)
+{
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1e6;
+}
+
+static uint8_t *put_delta(uint8_t *p, uint64_t d)
+{
+    do {
+        *p++ = (d & 0x7F) | (d > 0x7F ? 0x80 : 0);
+        d >>= 7;
+    } while (d);
+    return p;
+}
+
+static void drop_client(struct client *c)
+{
+    close(c->fd);
+    c->fd = -1;
+}
+
+// Send as much of the pending update as the socket takes
+static void flush_client(struct client *c)
+{
+    ssize_t n;
+
+    if (c->out_sent == c->out_len) {
+        return;
+    }
+    n = send(c->fd, c->out + c->out_sent, c->out_len - c->out_sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+        c->out_sent += n;
+    } else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        drop_client(c);
+    }
+}
+
+// Events to bring the client from c->shown to s
+static void build_update(struct client *c, const struct screen *s)
+{
+    uint8_t *p = c->out;
+    uint16_t at = c->shown.cursor;       // the viewer's idea of the cursor
+    int changes = 0;
+
+    for (int i = 0; i < LCDREC_CELLS; i++) {
+        changes += c->shown.cells[i] != s->cells[i];
+    }
+    if (!c->started) {
+        uint16_t cols = LCDREC_COLS, rows = LCDREC_ROWS;
+        memcpy(p, LCDREC_MAGIC, 8);
+        memcpy(p + 8, &clock_hz, 4);
+        memcpy(p + 12, &cols, 2);
+        memcpy(p + 14, &rows, 2);
+        p += LCDREC_HEADER_SIZE;
+    }
+
+    p = put_delta(p, s->cycle - c->shown.cycle);
+    if (!c->started || changes * 4 > LCDREC_CELLS) {
+        *p++ = LCDREC_SCREEN;
+        memcpy(p, s->cells, LCDREC_CELLS);
+        p += LCDREC_CELLS;
+        *p++ = s->cursor & 0xFF;
+        *p++ = s->cursor >> 8;
+        *p++ = s->mode;
+        c->started = 1;
+    } else {
+        int first = 1;
+        for (uint16_t i = 0; i < LCDREC_CELLS; i++) {
+            if (c->shown.cells[i] == s->cells[i]) {
+                continue;
+            }
+            if (!first) {
+                p = put_delta(p, 0);
+            }
+            first = 0;
+            if (i == at) {
+                *p++ = LCDREC_HERE;
+            } else {
+                *p++ = LCDREC_CELL;
+                *p++ = i & 0xFF;
+                *p++ = i >> 8;
+            }
+            *p++ = s->cells[i];
+            at = i + 1;
+        }
+        if (s->mode != c->shown.mode) {
+            if (!first) {
+                p = put_delta(p, 0);
+            }
+            first = 0;
+            *p++ = LCDREC_MODE;
+            *p++ = s->mode;
+        }
+        if (s->cursor != at) {
+            if (!first) {
+                p = put_delta(p, 0);
+            }
+            *p++ = LCDREC_CURSOR;
+            *p++ = s->cursor & 0xFF;
+            *p++ = s->cursor >> 8;
+        }
+    }
+    c->shown = *s;
+    c->out_len = p - c->out;
+    c->out_sent = 0;
+}
+
+static void accept_client(void)
+{
+    int fd = accept(listen_fd, NULL, NULL);
+
+    if (fd < 0) {
+        return;
+    }
+    for (int i = 0; i < LCD_STREAM_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            memset(&clients[i], 0, sizeof(clients[i]));
+            clients[i].fd = fd;
+            return;
+        }
+    }
+    close(fd);    // full up
+}
+
+static void *stream_thread(void *arg)
+{
+    struct pollfd p[LCD_STREAM_CLIENTS + 1];
+    struct client *who[LCD_STREAM_CLIENTS + 1];
+    struct screen frame;
+    int have_frame = 0;
+    double next_tick = now_ms();
+    char junk[256];
+    int n, timeout;
+
+    for (;;) {
+        p[0].fd = listen_fd;
+        p[0].events = POLLIN;
+        n = 1;
+        for (int i = 0; i < LCD_STREAM_CLIENTS; i++) {
+            if (clients[i].fd >= 0) {
+                p[n].fd = clients[i].fd;
+                p[n].events = POLLIN;    // only to notice the viewer leaving
+                if (clients[i].out_sent != clients[i].out_len) {
+                    p[n].events |= POLLOUT;
+                }
+                who[n++] = &clients[i];
+            }
+        }
+        timeout = next_tick - now_ms() + 1;
+        if (poll(p, n, timeout < 0 ? 0 : timeout) < 0) {
+            continue;
+        }
+
+        for (int i = 1; i < n; i++) {
+            if (p[i].revents & POLLOUT) {
+                flush_client(who[i]);
+            }
+            if (who[i]->fd >= 0 && (p[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                ssize_t got = read(who[i]->fd, junk, sizeof(junk));
+                if (got == 0 || (got < 0 && errno != EAGAIN)) {
+                    drop_client(who[i]);
+                }
+            }
+        }
+        if (p[0].revents & POLLIN) {
+            accept_client();
+        }
+
+        if (now_ms() < next_tick) {
+            continue;
+        }
+        next_tick += tick_ms;
+        if (next_tick < now_ms()) {
+            next_tick = now_ms() + tick_ms;    // don't try to catch up
+        }
+        pthread_mutex_lock(&lock);
+        if (latest_new) {
+            frame = latest;
+            latest_new = 0;
+            have_frame = 1;
+        }
+        pthread_mutex_unlock(&lock);
+        if (!have_frame) {
+            continue;
+        }
+        for (int i = 0; i < LCD_STREAM_CLIENTS; i++) {
+            struct client *c = &clients[i];
+            if (c->fd < 0 || c->out_sent != c->out_len) {
+                continue;
+            }
+            if (c->started && c->shown.cursor == frame.cursor && c->shown.mode == frame.mode
+                && !memcmp(c->shown.cells, frame.cells, LCDREC_CELLS)) {
+                continue;
+            }
+            build_update(c, &frame);
+            flush_client(c);
+        }
+    }
+    return NULL;
+}
+
+int lcd_stream_open(const char *path, uint32_t max_fps, uint32_t hz)
+{
+    struct sockaddr_un addr;
+    pthread_t thread;
+
+    if (!max_fps) {
+        max_fps = LCD_STREAM_FPS;
+    }
+    tick_ms = 1000.0 / max_fps;
+    clock_hz = hz;
+    for (int i = 0; i < LCD_STREAM_CLIENTS; i++) {
+        clients[i].fd = -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr))
+        || listen(listen_fd, LCD_STREAM_CLIENTS)) {
+        perror(path);
+        return -1;
+    }
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);
+
+    if (pthread_create(&thread, NULL, stream_thread, NULL)) {
+        printf("Can't start LCD stream thread\n");
+        return -1;
+    }
+    pthread_detach(thread);
+    lcd_stream_on = 1;
+    return 0;
+}
+
+void lcd_stream_frame(const uint8_t *cells, uint16_t cursor, uint8_t mode, uint64_t cycle)
+{
+    if (pthread_mutex_trylock(&lock)) {
+        return;    // stream thread is copying the last one
+    }
+    memcpy(latest.cells, cells, LCDREC_CELLS);
+    latest.cursor = cursor;
+    latest.mode = mode;
+    latest.cycle = cycle;
+    latest_new = 1;
+    pthread_mutex_unlock(&lock);
+}
+#endif // WASM
@@ -0,0 +1,32 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * LCD streaming over a Unix socket (terminal version only).
+ *
+ * Any number of viewers (up to LCD_STREAM_CLIENTS) can connect to the
+ * socket.  Each gets the header and events of an LCD recording (lcdrec.h):
+ * first an LCDREC_SCREEN with the whole screen, then only the cells, cursor
+ * and mode that changed, at most max_fps times a second of host time.
+ *
+ * The emulator only copies the screen into a shared buffer once per LCD
+ * frame; a thread does everything else.  A viewer that doesn't keep up just
+ * gets fewer, bigger updates, and connecting or disconnecting never holds up
+ * the emulation.
+ */
+
+#ifndef LCD_STREAM_H
+#define LCD_STREAM_H
+
+#include <stdint.h>
+
+#define LCD_STREAM_CLIENTS   8
+#define LCD_STREAM_FPS       10       // default frame rate cap
+
+int lcd_stream_open(const char *path, uint32_t max_fps, uint32_t clock_hz);   // -1 on error
+
+extern int lcd_stream_on;
+
+// Once per LCD frame.  Never blocks.
+void lcd_stream_frame(const uint8_t *cells, uint16_t cursor, uint8_t mode, uint64_t cycle);
+
+#endif
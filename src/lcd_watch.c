@@ -0,0 +1,123 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "lcd_watch.h"
+
+int lcd_watch_on = 0;
+
+/////////////////////////////
+// LCD watchers
+//
+// Writes only mark cells; the subscribers hear about them at the next frame,
+// so a screenful of writes is one callback.  Each subscriber has its own
+// stable time, and hears LCD_STABLE once per quiet spell (and not before the
+// first change).  screen[] is what the display shows, so power off and on
+// are changes, and writes while it is blanked only count at power on.
+
+struct watcher {
+    lcd_watch_fn fn;
+    void *arg;
+    uint64_t stable_cycles;
+    int quiet;                  // LCD_STABLE already sent since the last change
+};
+
+static struct watcher watchers[LCD_WATCH_MAX];
+static int n_watchers = 0;
+static uint32_t cycles_per_ms = 1228;
+
+static uint8_t screen[LCD_WATCH_CELLS];
+static uint8_t changed[LCD_WATCH_CELLS];
+static uint16_t changed_rows = 0;
+static uint16_t cursor = 0;
+static uint64_t last_change = 0;
+
+void lcd_watch_init(uint32_t clock_hz)
+{
+    cycles_per_ms = clock_hz / 1000;
+}
+
+int lcd_watch_add(lcd_watch_fn fn, void *arg, uint32_t stable_ms)
+{
+    struct watcher *w;
+
+    if (n_watchers == LCD_WATCH_MAX) {
+        return -1;
+    }
+    w = &watchers[n_watchers++];
+    w->fn = fn;
+    w->arg = arg;
+    w->stable_cycles = (uint64_t) stable_ms * cycles_per_ms;
+    w->quiet = 1;
+    lcd_watch_on = 1;
+    return 0;
+}
+
+void lcd_watch_cell(uint64_t cycle, uint16_t addr, uint8_t data)
+{
+    if (addr >= LCD_WATCH_CELLS || screen[addr] == data) {
+        return;
+    }
+    screen[addr] = data;
+    changed[addr] = 1;
+    changed_rows |= 1 << (addr / LCD_WATCH_COLS);
+    last_change = cycle;
+}
+
+void lcd_watch_cursor(uint16_t addr)
+{
+    cursor = addr;
+}
+
+void lcd_watch_screen(uint64_t cycle, const uint8_t *cells)
+{
+    for (int addr = 0; addr < LCD_WATCH_CELLS; addr++) {
+        lcd_watch_cell(cycle, addr, cells[addr]);
+    }
+}
+
+void lcd_watch_frame(uint64_t cycle)
+{
+    struct lcd_change c;
+
+    c.cycle = cycle;
+    c.last_change = last_change;
+    c.screen = screen;
+    c.cursor = cursor;
+    c.changed = changed;
+    if (changed_rows) {
+        c.kind = LCD_CHANGED;
+        c.rows = changed_rows;
+        for (int i = 0; i < n_watchers; i++) {
+            watchers[i].quiet = 0;
+            watchers[i].fn(&c, watchers[i].arg);
+        }
+        memset(changed, 0, sizeof(changed));
+        changed_rows = 0;
+    }
+
+    c.kind = LCD_STABLE;
+    c.rows = 0;
+    for (int i = 0; i < n_watchers; i++) {
+        if (!watchers[i].quiet && cycle - last_change >= watchers[i].stable_cycles) {
+            watchers[i].quiet = 1;
+            watchers[i].fn(&c, watchers[i].arg);
+        }
+    }
+}
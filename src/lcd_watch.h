@@ -0,0 +1,57 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * LCD change notification, for tools that drive the emulator and need to
+ * know when the screen shows a result.
+ *
+ * Subscribers are called back, in the emulator thread, once per LCD frame in
+ * which cells changed (with which rows and cells), and once the screen has
+ * then stayed the same for their own stable time in emulated milliseconds.
+ * Only cell contents count as changes: the firmware moves the hidden cursor
+ * around and blinks it all the time.  Plain C, no I/O.
+ */
+
+#ifndef LCD_WATCH_H
+#define LCD_WATCH_H
+
+#include <stdint.h>
+
+#define LCD_WATCH_COLS    46
+#define LCD_WATCH_ROWS    16
+#define LCD_WATCH_CELLS   (LCD_WATCH_COLS * LCD_WATCH_ROWS)
+#define LCD_WATCH_MAX     4         // subscribers
+
+// event kinds
+#define LCD_CHANGED       1         // cells changed since the last frame
+#define LCD_STABLE        2         // no change for stable_ms since last_change
+
+struct lcd_change {
+    int kind;
+    uint64_t cycle;                 // now
+    uint64_t last_change;           // cycle of the latest cell change
+    uint16_t rows;                  // LCD_CHANGED: bit n = something in row n changed
+    const uint8_t *changed;         // LCD_CHANGED: 1 for each cell that changed
+    const uint8_t *screen;          // whole screen, LCD_WATCH_CELLS chars
+    uint16_t cursor;                // LCD cursor address
+};
+
+typedef void (*lcd_watch_fn)(const struct lcd_change *c, void *arg);
+
+void lcd_watch_init(uint32_t clock_hz);
+
+// -1 if there are already LCD_WATCH_MAX subscribers
+int lcd_watch_add(lcd_watch_fn fn, void *arg, uint32_t stable_ms);
+
+extern int lcd_watch_on;        // someone has subscribed
+
+// From the LCD hardware (write_lcd_data)
+void lcd_watch_cell(uint64_t cycle, uint16_t addr, uint8_t data);
+void lcd_watch_cursor(uint16_t addr);
+
+// The display was blanked or unblanked (power off/on): what it shows now
+void lcd_watch_screen(uint64_t cycle, const uint8_t *cells);
+
+// Once per LCD frame: calls the subscribers
+void lcd_watch_frame(uint64_t cycle);
+
+#endif
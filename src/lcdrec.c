@@ -0,0 +1,233 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "lcdrec.h"
+
+int lcdrec_on = 0;
+
+#ifndef WASM
+#include <poll.h>
+#include <pthread.h>
+
+#include "ring.h"
+
+/////////////////////////////
+// LCD recorder
+//
+// We keep our own copy of the screen, so only real changes are recorded, and
+// track where the player will think the cursor is, so most characters don't
+// need an address.  If the ring is ever full, events are lost; the next
+// event is then a whole screen, so the player catches up.  Power off and on
+// are whole screens too; while the display is blanked the firmware's writes
+// aren't passed on, and show up in the screen at power on.
+//
+// Like the register log, the writer thread just empties the ring every
+// LCDREC_FLUSH_MSEC.
+
+#define LCDREC_RING_SIZE   (1 << 18)
+#define LCDREC_FLUSH_MSEC  50
+
+static uint8_t rec_buf[LCDREC_RING_SIZE];
+static struct ring rec_ring;
+static FILE *rec_file;
+static int quitting = 0;
+static pthread_t thread;
+
+static uint8_t cells[LCDREC_CELLS];    // screen as shown: blank while the power is off
+static uint16_t cursor = 0;            // LCD cursor address
+static uint8_t mode = 0;
+static uint16_t rec_cursor = 0;        // ... as the player will have them
+static uint8_t rec_mode = 0;
+static uint64_t last_cycle = 0;        // of the last event recorded
+static int lost = 0;                   // events lost, player needs the whole screen
+
+static void *lcdrec_thread(void *arg)
+{
+    uint8_t chunk[65536];
+    uint32_t n;
+
+    for (;;) {
+        n = ring_peek(&rec_ring, chunk, sizeof(chunk));
+        if (n) {
+            fwrite(chunk, 1, n, rec_file);
+            ring_drop(&rec_ring, n);
+            continue;
+        }
+        if (__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) {
+            fclose(rec_file);
+            return NULL;
+        }
+        fflush(rec_file);
+        poll(NULL, 0, LCDREC_FLUSH_MSEC);
+    }
+}
+
+// Write out what is left in the ring before we exit
+static void lcdrec_close(void)
+{
+    __atomic_store_n(&quitting, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+}
+
+int lcdrec_open(const char *filename, uint32_t clock_hz)
+{
+    uint8_t hdr[LCDREC_HEADER_SIZE];
+    uint16_t cols = LCDREC_COLS, rows = LCDREC_ROWS;
+
+    rec_file = fopen(filename, "wb");
+    if (!rec_file) {
+        perror(filename);
+        return -1;
+    }
+    memcpy(hdr, LCDREC_MAGIC, 8);     // includes the '\0'
+    memcpy(hdr + 8, &clock_hz, 4);
+    memcpy(hdr + 12, &cols, 2);
+    memcpy(hdr + 14, &rows, 2);
+    fwrite(hdr, 1, sizeof(hdr), rec_file);
+
+    ring_init(&rec_ring, rec_buf, LCDREC_RING_SIZE);
+    if (pthread_create(&thread, NULL, lcdrec_thread, NULL)) {
+        printf("Can't start LCD recorder thread\n");
+        fclose(rec_file);
+        return -1;
+    }
+    atexit(lcdrec_close);
+    lcdrec_on = 1;
+    return 0;
+}
+
+// Cycle delta + event.  -1 (and lost is set) if it didn't fit
+static int put_event(uint64_t cycle, const uint8_t *event, uint32_t n)
+{
+    uint8_t delta[10];
+    uint64_t d = cycle - last_cycle;
+    uint32_t len = 0;
+
+    do {
+        delta[len++] = (d & 0x7F) | (d > 0x7F ? 0x80 : 0);
+        d >>= 7;
+    } while (d);
+
+    if (ring_space(&rec_ring) < len + n) {
+        lost = 1;
+        return -1;
+    }
+    ring_write(&rec_ring, delta, len);
+    ring_write(&rec_ring, event, n);
+    last_cycle = cycle;
+    return 0;
+}
+
+static void put_screen(uint64_t cycle)
+{
+    uint8_t event[1 + LCDREC_CELLS + 3];
+
+    event[0] = LCDREC_SCREEN;
+    memcpy(event + 1, cells, LCDREC_CELLS);
+    event[1 + LCDREC_CELLS] = cursor & 0xFF;
+    event[2 + LCDREC_CELLS] = cursor >> 8;
+    event[3 + LCDREC_CELLS] = mode;
+    lost = 0;
+    if (put_event(cycle, event, sizeof(event)) == 0) {
+        rec_cursor = cursor;
+        rec_mode = mode;
+    }
+}
+
+void lcdrec_cell(uint64_t cycle, uint16_t addr, uint8_t data)
+{
+    uint8_t event[4];
+
+    cursor = addr + 1;
+    if (addr >= LCDREC_CELLS || cells[addr] == data) {
+        return;
+    }
+    cells[addr] = data;
+    if (lost) {
+        put_screen(cycle);
+        return;
+    }
+    if (addr == rec_cursor) {
+        event[0] = LCDREC_HERE;
+        event[1] = data;
+        if (put_event(cycle, event, 2)) {
+            return;
+        }
+    } else {
+        event[0] = LCDREC_CELL;
+        event[1] = addr & 0xFF;
+        event[2] = addr >> 8;
+        event[3] = data;
+        if (put_event(cycle, event, 4)) {
+            return;
+        }
+    }
+    rec_cursor = addr + 1;
+}
+
+// Not recorded until the frame, since the firmware moves the cursor around
+// a lot while it is hidden
+void lcdrec_cursor(uint64_t cycle, uint16_t addr)
+{
+    cursor = addr;
+}
+
+void lcdrec_mode(uint64_t cycle, uint8_t data)
+{
+    uint8_t event[2];
+
+    mode = data;
+    if (lost) {
+        put_screen(cycle);
+    } else if (mode != rec_mode) {
+        event[0] = LCDREC_MODE;
+        event[1] = mode;
+        if (put_event(cycle, event, 2) == 0) {
+            rec_mode = mode;
+        }
+    }
+}
+
+void lcdrec_screen(uint64_t cycle, const uint8_t *screen, uint16_t addr, uint8_t data)
+{
+    memcpy(cells, screen, LCDREC_CELLS);
+    cursor = addr;
+    mode = data;
+    put_screen(cycle);
+}
+
+void lcdrec_frame(uint64_t cycle)
+{
+    uint8_t event[3];
+
+    if (lost) {
+        put_screen(cycle);
+    } else if ((mode & 0x08) && cursor != rec_cursor) {
+        event[0] = LCDREC_CURSOR;
+        event[1] = cursor & 0xFF;
+        event[2] = cursor >> 8;
+        if (put_event(cycle, event, 3) == 0) {
+            rec_cursor = cursor;
+        }
+    }
+}
+#endif // WASM
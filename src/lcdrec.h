@@ -0,0 +1,67 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * LCD recording (terminal version only).
+ *
+ * Records every change the firmware makes to the 46x16 character screen,
+ * stamped with the cycle it happened on, as a small delta stream.  Writes
+ * that don't change a cell aren't recorded, and a cell written next to the
+ * last one doesn't repeat its address, so a typical session is a few bytes
+ * per changed character.  A background thread writes the file.  Play it
+ * back, or turn it into frames, with tools/lcdplay.
+ *
+ * File format (host byte order):
+ *
+ *   0   8 bytes   "WSLCD1\n\0"
+ *   8   uint32    E clock frequency, to turn cycles into seconds
+ *   12  uint16    columns (46)
+ *   14  uint16    rows (16)
+ *   16  events
+ *
+ * Each event is the number of cycles since the previous event (LEB128: 7
+ * bits per byte, low bits first, bit 7 set on all but the last byte),
+ * followed by one of:
+ *
+ *   LCDREC_HERE    char              char at the cursor; cursor moves on
+ *   LCDREC_CELL    addr(2) char      char at addr; cursor goes to addr+1
+ *   LCDREC_CURSOR  addr(2)           cursor moves
+ *   LCDREC_MODE    mode              LCD mode byte (bit 3 = cursor shown)
+ *   LCDREC_SCREEN  736 chars, addr(2), mode
+ *                                    whole screen, after events were lost
+ *                                    or when the power goes off or on
+ *
+ * addr is the LCD RAM address, little endian; only the first 736 cells are
+ * on the screen.  Cursor moves are written at most once per LCD frame.
+ */
+
+#ifndef LCDREC_H
+#define LCDREC_H
+
+#include <stdint.h>
+
+#define LCDREC_MAGIC        "WSLCD1\n"
+#define LCDREC_HEADER_SIZE  16
+#define LCDREC_COLS         46
+#define LCDREC_ROWS         16
+#define LCDREC_CELLS        (LCDREC_COLS * LCDREC_ROWS)
+
+// event types
+#define LCDREC_HERE     1
+#define LCDREC_CELL     2
+#define LCDREC_CURSOR   3
+#define LCDREC_MODE     4
+#define LCDREC_SCREEN   5
+
+int lcdrec_open(const char *filename, uint32_t clock_hz);   // -1 on error
+extern int lcdrec_on;
+
+// What the firmware did, from write_lcd_data().  None of these block.
+void lcdrec_cell(uint64_t cycle, uint16_t addr, uint8_t data);
+void lcdrec_cursor(uint64_t cycle, uint16_t addr);
+void lcdrec_mode(uint64_t cycle, uint8_t mode);
+void lcdrec_frame(uint64_t cycle);      // once per LCD frame
+
+// The display was blanked or unblanked (power off/on): what it shows now
+void lcdrec_screen(uint64_t cycle, const uint8_t *screen, uint16_t addr, uint8_t mode);
+
+#endif
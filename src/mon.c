@@ -28,14 +28,17 @@
 #include "utils.h"
 #include "asm6800.h"
 #include "unasm6800.h"    /* JMR20201105 */
+#include "disasm.h"
 #include "sim6800.h"
 #include "workslate.h"
+#include "kbd_reader.h"
 
 FILE *mon_out;
 FILE *mon_in;
 
 int last;
 unsigned short last_u;
+int last_u_bank = -1;
 int step;
 
 // Not really external, but we define it later.  Alternative is to use function prototypes
@@ -331,21 +334,52 @@ int a_cmd(char *p)
 
 int u_cmd(char *p)
 {
-    char buf[180];
+    char buf[DISASM_LINE];
     int addr = last_u;
-    if (parse_hex(&p, &addr) || !*p) {
-//        int target;
-        int x;
+    int bank = last_u_bank;
+    int len = 0;
+    int x;
+    if (*p) {
+        if (!parse_hex(&p, &addr)) {
+            huh();
+            return 0;
+        }
+        if (*p == '.') {    /* bank.addr */
+            ++p;
+            bank = addr;
+            if (bank > 3 || !parse_hex(&p, &addr)) {   /* banks 0-3 */
+                huh();
+                return 0;
+            }
+        } else {
+            bank = get_bank();
+        }
+        skipws(&p);
+        if (*p && !parse_hex(&p, &len)) {
+            huh();
+            return 0;
+        }
+    } else if (bank < 0) {
+        bank = get_bank();
+    }
+    if (len) {
+        /* List up to addr + len, stopping if it wraps past FFFF */
+        int end = addr + len;
+        while (addr < end) {
+            int next = disasm_line(bank, addr, buf);
+            fprintf(mon_out, "%s\n", buf);
+            if (next <= addr)
+                break;
+            addr = next;
+        }
+    } else {
         for (x = 0; x != 22; ++x) {
-            unsigned short saddr = (unsigned short) addr;    /* JMR20201105 hidden endian issues */
-#warning "unassemble not completed"
-//            unasm_line(mem, &saddr, buf, &target, 1);    /* JMR20201105 */
-            addr = saddr;    /* JMR20201105 ugly hack, let Joe figure it out. */
+            addr = disasm_line(bank, addr, buf);
             fprintf(mon_out, "%s\n", buf);
         }
-        last_u = addr;
-    } else
-        huh();
+    }
+    last_u = addr;
+    last_u_bank = bank;
     return 0;
 }
 
@@ -491,7 +525,7 @@ struct cmd cmds[]=
     { "a", a_cmd,        " hhhh          Assemble" },
     { "clr", clr_cmd,    "             Clear symbol table" },
     { "sy", sy_cmd,      "              Show symbol table" },
-    { "u", u_cmd,        " hhhh          Unassemble" },
+    { "u", u_cmd,        " [b.]hhhh [nnnn]  Unassemble (bank b, default the current one)" },
 //    { "p", p_cmd,        " hhhh nnnn [ssss]    Punch S19" },
 //    { "l", l_cmd,        "            Load S19" },
 //    { "save", dump_cmd,    " [file [hhhh [nnnn]]]    Save memory to file in binary\n" },
@@ -512,6 +546,9 @@ void monitor()
 
     /* system("stty -isig"); */
     nosig_termios();
+#ifndef WASM
+    kbd_reader_pause();     /* we read stdin now */
+#endif
 
     if (step) {
         if (trace)
@@ -592,4 +629,8 @@ void monitor()
     }
     /* system("stty isig"); */
     sig_termios();
+#ifndef WASM
+    if (!stop)              /* (still ours if single stepping) */
+        kbd_reader_resume();
+#endif
 }
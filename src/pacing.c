@@ -0,0 +1,343 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "pacing.h"
+#include "utils.h"
+
+#ifndef WASM   // WASM regulates time with requestAnimationFrame instead
+
+/////////////////////////////
+// Real-time pacing
+//
+// Emulated time is turned into a host deadline: every checkpoint adds the
+// host time its cycles should have taken and sleeps until then (absolute
+// sleeps, so oversleeping in one step doesn't accumulate).
+//
+// The checkpoint spacing adapts to the host.  We measure how late each sleep
+// wakes up and keep that overshoot around 1/8 of a step: a host with a coarse
+// timer gets fewer, longer sleeps; a precise one gets finer steps (smoother
+// timing).  If we fall too far behind (slow host, or we sat in the monitor)
+// the deadline is resynchronized instead of running flat out to catch up.
+//
+// In "max" mode there is no deadline and no sleep call at all.  Checkpoints
+// still happen so the RTC keeps ticking with the host clock.
+//
+// "auto" mode (auto turbo) paces at 1x while the firmware is idle, and runs
+// unthrottled while it's busy.  The firmware SLPs between interrupts when it
+// has nothing to do, so a whole step without a SLP means it is recalculating,
+// sorting, etc. and the user is waiting on it.  The deadline is resynced after
+// every busy step, so pacing picks up again from "now" when the burst ends.
+// The RTC follows the host clock, so it is still right after a burst.
+// pacing_set_turbo() does the same on request, e.g. while the tape is moving.
+//
+// When the CPU is in SLP, the hardware code knows how many cycles it is until
+// the next timer/RTC/serial event and calls pacing_idle().  That blocks in one
+// poll() on the wake fd (keyboard input) with the event's deadline as the timeout,
+// instead of waking up every step.  poll() is used rather than timerfd/epoll
+// so this still builds on OSX.
+
+#define NSEC_PER_SEC        1000000000LL
+#define STEP_NS_DEFAULT        5000000LL  // 5 msec - the old fixed SLEEP_STEP_TIME
+#define STEP_NS_MIN            2000000LL
+#define STEP_NS_MAX           20000000LL
+#define MAX_LAG_NS           100000000LL  // give up catching up after 100 msec
+
+uint32_t pacing_countdown = 1;  // first cycle runs the checkpoint to start things up
+
+static uint32_t clock_hz = 1228800;
+static double speed = 1.0;              // emulated seconds per host second.  0=unthrottled
+static int64_t step_ns = STEP_NS_DEFAULT;
+static int64_t pending_ns = 0;          // host time covered by the cycles in pacing_countdown
+static double pending_ns_frac = 0;      // left over from rounding pending_ns
+static int64_t oversleep_avg_ns = STEP_NS_DEFAULT / 8;  // smoothed sleep overshoot
+static struct timespec deadline;
+static time_t last_second;
+static int started = 0;
+static int auto_turbo = 0;
+static int idle_seen = 0;               // SLP happened during this step
+static int turbo = 0;                   // forced unthrottled
+static uint32_t pending_cycles = 1;     // cycles in the current step
+static int wake_fd = -1;
+static int serial_wake_fd = -1;
+int pacing_input_ready = 0;
+
+static int second_rolled(const struct timespec *now)
+{
+    if (now->tv_sec != last_second) {
+        last_second = now->tv_sec;
+        return 1;
+    }
+    return 0;
+}
+
+// Wait up to timeout_ms for input.  Returns non-zero if woken early (input or signal).
+// The keyboard's pipe is left alone while pacing_input_ready is set.
+static int poll_wake_fd(int timeout_ms)
+{
+    struct pollfd pfd[2];
+    int n = 0;
+    int rtn;
+
+    if (wake_fd >= 0 && !pacing_input_ready) {
+        pfd[n].fd = wake_fd;
+        pfd[n++].events = POLLIN;
+    }
+    if (serial_wake_fd >= 0) {
+        pfd[n].fd = serial_wake_fd;
+        pfd[n++].events = POLLIN;
+    }
+    rtn = poll(pfd, n, timeout_ms);
+    for (int i = 0; rtn > 0 && i < n; i++) {
+        if (pfd[i].revents & POLLIN) {
+            char buf[64];
+            while (read(pfd[i].fd, buf, sizeof(buf)) == sizeof(buf))
+                ;   // empty the pipe
+            if (pfd[i].fd == wake_fd) {
+                pacing_input_ready = 1;  // remembered until the input is taken
+            }
+        }
+    }
+    return rtn != 0;
+}
+
+static int64_t ts_to_ns(const struct timespec *ts)
+{
+    return (int64_t) ts->tv_sec * NSEC_PER_SEC + ts->tv_nsec;
+}
+
+static void ns_to_ts(int64_t ns, struct timespec *ts)
+{
+    ts->tv_sec = ns / NSEC_PER_SEC;
+    ts->tv_nsec = ns % NSEC_PER_SEC;
+}
+
+// Start a new step: the whole number of cycles nearest to step_ns of host
+// time, and the host time those cycles really stand for.  The fraction of a
+// nanosecond left over is carried to the next step, so nothing drifts.
+static void start_step(void)
+{
+    double s = speed ? speed : 1.0;
+    double c = (double) step_ns * clock_hz * s / NSEC_PER_SEC;
+    double ns;
+
+    pacing_countdown = (c < 1) ? 1 : (uint32_t) c;
+    pending_cycles = pacing_countdown;
+    ns = (double) pacing_countdown * NSEC_PER_SEC / clock_hz / s + pending_ns_frac;
+    pending_ns = (int64_t) ns;
+    pending_ns_frac = ns - pending_ns;
+}
+
+void pacing_init(uint32_t hz)
+{
+    clock_hz = hz;
+    started = 0;
+    pacing_countdown = 1;
+}
+
+int pacing_set_speed(const char *spec)
+{
+    char *end;
+    double s;
+
+    auto_turbo = 0;
+    if (!strcmp(spec, "max")) {
+        speed = 0;
+        return 0;
+    }
+    if (!strcmp(spec, "auto")) {
+        speed = 1.0;
+        auto_turbo = 1;
+        started = 0;
+        return 0;
+    }
+    s = strtod(spec, &end);
+    if (end == spec || s <= 0 || (*end && strcmp(end, "x"))) {
+        return -1;
+    }
+    speed = s;
+    started = 0;  // resync deadline to new rate
+    return 0;
+}
+
+double pacing_get_speed(void)
+{
+    return speed;
+}
+
+void pacing_note_idle(void)
+{
+    idle_seen = 1;
+}
+
+void pacing_set_turbo(int on)
+{
+    turbo = on;
+}
+
+void pacing_set_wake_fd(int fd)
+{
+    wake_fd = fd;
+    pacing_input_ready = 0;
+}
+
+void pacing_set_serial_wake_fd(int fd)
+{
+    serial_wake_fd = fd;
+}
+
+static void adapt_step(int64_t oversleep_ns)
+{
+    // exponential average, 1/8 weight for new samples
+    oversleep_avg_ns += (oversleep_ns - oversleep_avg_ns) / 8;
+    step_ns = oversleep_avg_ns * 8;
+    if (step_ns < STEP_NS_MIN) step_ns = STEP_NS_MIN;
+    if (step_ns > STEP_NS_MAX) step_ns = STEP_NS_MAX;
+}
+
+int pacing_checkpoint(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (!started) {
+        started = 1;
+        deadline = now;
+        last_second = now.tv_sec;
+    }
+
+    if (turbo || (auto_turbo && !idle_seen)) {
+        deadline = now;   // busy: run flat out, and restart pacing from here
+    } else if (speed) {
+        int64_t target = ts_to_ns(&deadline) + pending_ns;
+        int64_t lag = ts_to_ns(&now) - target;
+
+        if (lag > MAX_LAG_NS) {
+            target = ts_to_ns(&now);   // can't keep up - don't try to make it up later
+        } else if (lag < 0) {
+            ns_to_ts(target, &deadline);
+#ifdef __MACH__
+            clock_nanosleep_abstime(&deadline);
+#else
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL);
+#endif
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            adapt_step(ts_to_ns(&now) - target);
+        }
+        ns_to_ts(target, &deadline);
+    }
+
+    if (wake_fd >= 0 && !pacing_input_ready) {
+        poll_wake_fd(0);
+    }
+
+    idle_seen = 0;
+    start_step();
+    return second_rolled(&now);
+}
+
+uint32_t pacing_idle(uint32_t cycles, int *rolled)
+{
+    struct timespec now;
+    uint32_t done = pending_cycles - pacing_countdown;  // cycles already run in this step
+    double ns_per_cycle;
+    int64_t start, target;
+    uint32_t elapsed;
+
+    idle_seen = 1;
+    if (!speed || turbo || !started) {
+        // unthrottled: just skip ahead
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        *rolled = second_rolled(&now);
+        start_step();
+        return cycles;
+    }
+
+    ns_per_cycle = (double) NSEC_PER_SEC / clock_hz / speed;
+    start = ts_to_ns(&deadline);
+    target = start + (int64_t) ((done + (double) cycles) * ns_per_cycle);
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    while (ts_to_ns(&now) < target) {
+        int64_t wait_ns = target - ts_to_ns(&now);
+        int woken = 0;
+        if (pacing_input_ready && serial_wake_fd < 0) {
+            // input is already waiting for the firmware to read it - don't poll for it again
+            struct timespec ts;
+            ns_to_ts(target, &ts);
+#ifdef __MACH__
+            clock_nanosleep_abstime(&ts);
+#else
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+#endif
+        } else {
+            woken = poll_wake_fd((int) ((wait_ns + 999999) / 1000000));  // round up to msec
+        }
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (woken) {
+            break;
+        }
+    }
+
+    // work out how far emulated time got
+    if (ts_to_ns(&now) >= target) {
+        elapsed = cycles;
+    } else {
+        double c = (ts_to_ns(&now) - start) / ns_per_cycle - done;
+        elapsed = (c < 1) ? 1 : (c > cycles) ? cycles : (uint32_t) c;
+    }
+    if (ts_to_ns(&now) - target > MAX_LAG_NS) {
+        deadline = now;
+    } else {
+        ns_to_ts(start + (int64_t) ((done + (double) elapsed) * ns_per_cycle), &deadline);
+    }
+
+    // start a new step from here
+    *rolled = second_rolled(&now);
+    start_step();
+    return elapsed;
+}
+
+uint32_t pacing_wait_input(uint32_t cycles, int *rolled)
+{
+    struct timespec now;
+    int64_t start, ns;
+    double c;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    start = ts_to_ns(&now);
+    if (!pacing_input_ready) {
+        ns = (int64_t) ((double) cycles * NSEC_PER_SEC / clock_hz);
+        poll_wake_fd((int) ((ns + 999999) / 1000000));  // round up to msec
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // emulated time follows the host, whatever the speed
+    c = (double) (ts_to_ns(&now) - start) * clock_hz / NSEC_PER_SEC;
+    deadline = now;
+    *rolled = second_rolled(&now);
+    start_step();
+    return (c > cycles) ? cycles : (uint32_t) c;
+}
+#endif // WASM
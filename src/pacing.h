@@ -0,0 +1,49 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Real-time pacing for the terminal build.
+ *
+ * The hardware code counts E cycles and calls pacing_checkpoint() every
+ * pacing_countdown cycles.  The checkpoint sleeps until the host has caught
+ * up with the emulated time (scaled by the speed multiplier), and adjusts
+ * the checkpoint spacing to suit how precisely the host can sleep.
+ */
+
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdint.h>
+
+extern uint32_t pacing_countdown;   // cycles left until the next pacing_checkpoint()
+
+void pacing_init(uint32_t clock_hz);
+int pacing_set_speed(const char *spec);  // "1x", "4x", "0.5x", "max", "auto".  Returns -1 if not understood
+double pacing_get_speed(void);           // 0 means unthrottled
+void pacing_note_idle(void);             // CPU is idle (SLP) - used by "auto"
+void pacing_set_turbo(int on);           // run unthrottled while on, whatever the speed (tape fast mode)
+
+// returns non-zero when a host second has rolled over since the last checkpoint
+int pacing_checkpoint(void);
+
+// Input that should wake us up from an idle wait: a non-blocking pipe from
+// the keyboard reader.  It is emptied here, so the reader of the input must
+// clear pacing_input_ready once it has taken everything.  -1 for none.
+void pacing_set_wake_fd(int fd);
+extern int pacing_input_ready;      // set when the wake fd has something to read
+
+// The serial bridge's pipe, written when received bytes arrive in an empty
+// ring.  It only ends an idle wait early: the serial port is checked every
+// cycle anyway.
+void pacing_set_serial_wake_fd(int fd);
+
+// The CPU is asleep and nothing happens for the next 'cycles' cycles.  Block the
+// host until that much emulated time has passed (or input arrives), start a new
+// step, and return how many cycles really elapsed.
+uint32_t pacing_idle(uint32_t cycles, int *second_rolled);
+
+// The machine is switched off.  Like pacing_idle(), but emulated time follows
+// the host clock at any speed: with the firmware stopped there is nothing to
+// run flat out, and the RTC has to stay right.
+uint32_t pacing_wait_input(uint32_t cycles, int *second_rolled);
+
+#endif
@@ -0,0 +1,123 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "reglog.h"
+
+int reglog_on = 0;
+
+#ifndef WASM
+#include <poll.h>
+#include <pthread.h>
+
+#include "ring.h"
+
+/////////////////////////////
+// Register log writer
+//
+// The writer thread doesn't need waking: it empties the ring every
+// REGLOG_FLUSH_MSEC, which is far more often than it can fill up.
+
+#define REGLOG_RING_SIZE   (1 << 20)          // 64K records
+#define REGLOG_FLUSH_MSEC  50
+
+static uint8_t log_buf[REGLOG_RING_SIZE];
+static struct ring log_ring;
+static FILE *log_file;
+static uint32_t dropped = 0;          // records lost since the last one that got in
+static int quitting = 0;
+static pthread_t thread;
+
+static void *reglog_thread(void *arg)
+{
+    uint8_t chunk[65536];
+    uint32_t n;
+
+    for (;;) {
+        n = ring_peek(&log_ring, chunk, sizeof(chunk));
+        if (n) {
+            fwrite(chunk, 1, n, log_file);
+            ring_drop(&log_ring, n);
+            continue;
+        }
+        if (__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) {
+            fclose(log_file);
+            return NULL;
+        }
+        fflush(log_file);
+        poll(NULL, 0, REGLOG_FLUSH_MSEC);
+    }
+}
+
+// Write out what is left in the ring before we exit
+static void reglog_close(void)
+{
+    __atomic_store_n(&quitting, 1, __ATOMIC_RELEASE);
+    pthread_join(thread, NULL);
+}
+
+int reglog_open(const char *filename, uint32_t clock_hz)
+{
+    uint8_t hdr[REGLOG_HEADER_SIZE];
+    uint32_t size = sizeof(struct reglog_record);
+
+    log_file = fopen(filename, "wb");
+    if (!log_file) {
+        perror(filename);
+        return -1;
+    }
+    memcpy(hdr, REGLOG_MAGIC, 8);
+    memcpy(hdr + 8, &size, 4);
+    memcpy(hdr + 12, &clock_hz, 4);
+    fwrite(hdr, 1, sizeof(hdr), log_file);
+
+    ring_init(&log_ring, log_buf, REGLOG_RING_SIZE);
+    if (pthread_create(&thread, NULL, reglog_thread, NULL)) {
+        printf("Can't start register log thread\n");
+        fclose(log_file);
+        return -1;
+    }
+    atexit(reglog_close);
+    reglog_on = 1;
+    return 0;
+}
+
+void reglog_write(const struct reglog_record *r)
+{
+    struct reglog_record d;
+
+    if (dropped) {
+        if (ring_space(&log_ring) < 2 * sizeof(*r)) {
+            dropped++;
+            return;
+        }
+        d = *r;
+        d.kind = REGLOG_DROPPED;
+        d.value = dropped > 255 ? 255 : dropped;
+        ring_write(&log_ring, &d, sizeof(d));
+        dropped = 0;
+    } else if (ring_space(&log_ring) < sizeof(*r)) {
+        dropped = 1;
+        return;
+    }
+    ring_write(&log_ring, r, sizeof(*r));
+}
+#endif // WASM
@@ -0,0 +1,48 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Binary register access log (terminal version only).
+ *
+ * The hardware code's logit() fills in one fixed-size record per register
+ * access and drops it into a ring buffer; a background thread writes the
+ * ring to the log file.  Logging never blocks the emulator: if the writer
+ * falls behind, records are counted and a REGLOG_DROPPED record says how
+ * many were lost.  Decode the file with tools/reglog_decode.
+ *
+ * File format (host byte order):
+ *
+ *   0   8 bytes   "WSRLOG1\n"
+ *   8   uint32    record size (sizeof(struct reglog_record))
+ *   12  uint32    E clock frequency, to turn cycles into seconds
+ *   16  records
+ */
+
+#ifndef REGLOG_H
+#define REGLOG_H
+
+#include <stdint.h>
+
+#define REGLOG_MAGIC       "WSRLOG1\n"
+#define REGLOG_HEADER_SIZE 16
+
+// record kinds
+#define REGLOG_READ      0
+#define REGLOG_WRITE     1
+#define REGLOG_EVENT     2     // something the hardware did by itself (flag set, etc.)
+#define REGLOG_DROPPED   3     // value = number of records lost before this one (max 255)
+
+struct reglog_record {
+    uint64_t cycle;            // cycle_count
+    uint16_t pc;
+    uint8_t bank;
+    uint8_t reg;               // I/O address
+    uint8_t value;
+    uint8_t kind;              // REGLOG_*
+    uint8_t pad[2];
+};
+
+int reglog_open(const char *filename, uint32_t clock_hz);   // -1 on error
+extern int reglog_on;
+void reglog_write(const struct reglog_record *r);           // never blocks
+
+#endif
@@ -0,0 +1,108 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Lock-free byte ring buffer, for passing data between one producer thread
+ * and one consumer thread.
+ *
+ * The producer only writes head and the consumer only writes tail, so no
+ * locks are needed: each side publishes its index with a release store after
+ * touching the data, and reads the other side's index with an acquire load.
+ * The indexes run freely and are masked on use, so size must be a power of 2.
+ */
+
+#ifndef RING_H
+#define RING_H
+
+#include <stdint.h>
+#include <string.h>
+
+struct ring {
+    uint8_t *buf;
+    uint32_t size;       // power of 2
+    uint32_t head;       // next byte to write - producer only
+    uint32_t tail;       // next byte to read - consumer only
+};
+
+static inline void ring_init(struct ring *r, uint8_t *buf, uint32_t size)
+{
+    r->buf = buf;
+    r->size = size;
+    r->head = 0;
+    r->tail = 0;
+}
+
+static inline uint32_t ring_count(struct ring *r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+static inline uint32_t ring_space(struct ring *r)
+{
+    return r->size - ring_count(r);
+}
+
+// Producer: returns -1 if full
+static inline int ring_put(struct ring *r, uint8_t c)
+{
+    uint32_t h = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+
+    if (h - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) == r->size) {
+        return -1;
+    }
+    r->buf[h & (r->size - 1)] = c;
+    __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Consumer: returns -1 if empty
+static inline int ring_get(struct ring *r)
+{
+    uint32_t t = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    uint8_t c;
+
+    if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == t) {
+        return -1;
+    }
+    c = r->buf[t & (r->size - 1)];
+    __atomic_store_n(&r->tail, t + 1, __ATOMIC_RELEASE);
+    return c;
+}
+
+// Producer: copy in as much of src as fits.  Returns bytes written
+static inline uint32_t ring_write(struct ring *r, const void *src, uint32_t n)
+{
+    uint32_t h = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+    uint32_t space = r->size - (h - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE));
+    uint32_t i = h & (r->size - 1);
+    uint32_t first;
+
+    if (n > space) n = space;
+    first = (n < r->size - i) ? n : r->size - i;
+    memcpy(r->buf + i, src, first);
+    memcpy(r->buf, (const uint8_t *) src + first, n - first);
+    __atomic_store_n(&r->head, h + n, __ATOMIC_RELEASE);
+    return n;
+}
+
+// Consumer: copy out up to n bytes without removing them.  Returns bytes copied
+static inline uint32_t ring_peek(struct ring *r, void *dst, uint32_t n)
+{
+    uint32_t t = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+    uint32_t count = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - t;
+    uint32_t i = t & (r->size - 1);
+    uint32_t first;
+
+    if (n > count) n = count;
+    first = (n < r->size - i) ? n : r->size - i;
+    memcpy(dst, r->buf + i, first);
+    memcpy((uint8_t *) dst + first, r->buf, n - first);
+    return n;
+}
+
+// Consumer: remove n bytes (after a ring_peek())
+static inline void ring_drop(struct ring *r, uint32_t n)
+{
+    __atomic_store_n(&r->tail, __atomic_load_n(&r->tail, __ATOMIC_RELAXED) + n, __ATOMIC_RELEASE);
+}
+
+#endif
@@ -0,0 +1,291 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#define _GNU_SOURCE     // posix_openpt() and friends, cfmakeraw()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "serial_bridge.h"
+
+int serial_bridge_on = 0;
+
+#ifndef WASM
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "pacing.h"
+#include "ring.h"
+
+/////////////////////////////
+// Serial bridge
+//
+// The emulator thread is the consumer of rx and the producer of tx; the
+// bridge thread is the other end of each.  The bridge thread sleeps in poll()
+// and is woken through a pipe when the emulator empties a full rx ring or
+// puts the first byte into an empty tx ring.  The other way round, bytes
+// arriving in an empty rx ring wake the emulator (pacing.c) from an idle wait
+// through a second pipe, so the firmware hears about them before its next
+// timer tick.
+//
+// On a unix socket, the peer leaving (POLLHUP, end of file or an error) closes
+// the connection and the thread goes back to waiting for the next one.  What
+// the WorkSlate sends meanwhile waits in tx.
+
+#define BRIDGE_RING_SIZE   65536      // about a minute of 9600 baud
+#define BRIDGE_CHUNK       4096
+#define BRIDGE_RETRY_MSEC  100        // back off this long after an error
+
+static uint8_t rx_buf[BRIDGE_RING_SIZE];
+static uint8_t tx_buf[BRIDGE_RING_SIZE];
+static struct ring rx;                // host to WorkSlate
+static struct ring tx;                // WorkSlate to host
+
+static int host_fd = -1;              // pty master or connected socket
+static int listen_fd = -1;            // unix socket, waiting for a peer
+static int wake_pipe[2];
+static int emulator_pipe[2];          // bridge to emulator
+
+static void wake_pipe_write(int fd)
+{
+    char c = 0;
+
+    if (write(fd, &c, 1) < 0) {
+        // pipe already full, so a wakeup is pending anyway
+    }
+}
+
+static void wake_bridge(void)
+{
+    wake_pipe_write(wake_pipe[1]);
+}
+
+static void wake_emulator(void)
+{
+    wake_pipe_write(emulator_pipe[1]);
+}
+
+static int soft_error(void)
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+static void hang_up(void)
+{
+    if (listen_fd >= 0) {
+        close(host_fd);           // peer went away - wait for the next one
+        host_fd = -1;
+    } else {
+        poll(NULL, 0, BRIDGE_RETRY_MSEC);   // pty trouble: don't spin on it
+    }
+}
+
+// Wait for a peer to connect to the unix socket
+static void accept_peer(void)
+{
+    struct pollfd p;
+
+    p.fd = listen_fd;
+    p.events = POLLIN;
+    if (poll(&p, 1, -1) <= 0) {
+        return;
+    }
+    host_fd = accept(listen_fd, NULL, NULL);
+    if (host_fd < 0 && !soft_error()) {
+        poll(NULL, 0, BRIDGE_RETRY_MSEC);   // e.g. out of file descriptors
+    }
+}
+
+static void *bridge_thread(void *arg)
+{
+    uint8_t chunk[BRIDGE_CHUNK];
+    struct pollfd p[2];
+    ssize_t n;
+
+    for (;;) {
+        if (host_fd < 0) {
+            accept_peer();
+            continue;
+        }
+
+        p[0].fd = host_fd;
+        p[0].events = 0;
+        if (ring_space(&rx)) {         // backpressure: leave it in the kernel
+            p[0].events |= POLLIN;
+        }
+        if (ring_count(&tx)) {
+            p[0].events |= POLLOUT;
+        }
+        p[1].fd = wake_pipe[0];
+        p[1].events = POLLIN;
+        if (poll(p, 2, -1) < 0) {
+            continue;
+        }
+
+        if (p[1].revents & POLLIN) {
+            while (read(wake_pipe[0], chunk, sizeof(chunk)) == sizeof(chunk))
+                ;
+        }
+        if (p[0].revents & POLLIN) {
+            uint32_t space = ring_space(&rx);
+            n = read(host_fd, chunk, space < sizeof(chunk) ? space : sizeof(chunk));
+            if (n > 0) {
+                int was_empty = !ring_count(&rx);
+                ring_write(&rx, chunk, n);
+                if (was_empty) {
+                    wake_emulator();
+                }
+            } else if (n == 0 || !soft_error()) {
+                hang_up();            // (OSX sockets give end of file without POLLHUP)
+                continue;
+            }
+        }
+        if (p[0].revents & POLLOUT) {
+            uint32_t len = ring_peek(&tx, chunk, sizeof(chunk));
+            if (listen_fd >= 0) {
+                n = send(host_fd, chunk, len, MSG_NOSIGNAL);   // no SIGPIPE if the peer has gone
+            } else {
+                n = write(host_fd, chunk, len);
+            }
+            if (n > 0) {
+                ring_drop(&tx, n);
+            } else if (n < 0 && !soft_error()) {
+                hang_up();
+                continue;
+            }
+        }
+        if (p[0].revents & (POLLHUP | POLLERR)) {
+            hang_up();
+        }
+    }
+    return NULL;
+}
+
+static int open_pty(void)
+{
+    struct termios t;
+    const char *name;
+
+    host_fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if (host_fd < 0 || grantpt(host_fd) || unlockpt(host_fd) || !(name = ptsname(host_fd))) {
+        perror("pty");
+        return -1;
+    }
+    // Keep the slave open ourselves, so the master doesn't hang up whenever
+    // the peer closes it.  It is also where the line is made raw.
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave < 0 || tcgetattr(slave, &t)) {
+        perror(name);
+        return -1;
+    }
+    cfmakeraw(&t);
+    tcsetattr(slave, TCSANOW, &t);
+    printf("Serial port is on %s\n", name);
+    return 0;
+}
+
+static int open_unix(const char *path)
+{
+    struct sockaddr_un addr;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        printf("Socket path %s is too long\n", path);
+        return -1;
+    }
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr *) &addr, sizeof(addr)) || listen(listen_fd, 1)) {
+        perror(path);
+        return -1;
+    }
+    fcntl(listen_fd, F_SETFL, O_NONBLOCK);   // accept() after poll() mustn't block if the peer has gone
+    printf("Serial port is on %s\n", path);
+    return 0;
+}
+
+int serial_bridge_open(const char *spec)
+{
+    pthread_t thread;
+
+    ring_init(&rx, rx_buf, BRIDGE_RING_SIZE);
+    ring_init(&tx, tx_buf, BRIDGE_RING_SIZE);
+    if (!strcmp(spec, "pty")) {
+        if (open_pty()) return -1;
+    } else if (!strncmp(spec, "unix:", 5)) {
+        if (open_unix(spec + 5)) return -1;
+    } else {
+        printf("Unknown serial port %s (use pty or unix:path)\n", spec);
+        return -1;
+    }
+    if (pipe(wake_pipe) || pipe(emulator_pipe)) {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    fcntl(emulator_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(emulator_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&thread, NULL, bridge_thread, NULL)) {
+        printf("Can't start serial thread\n");
+        return -1;
+    }
+    pthread_detach(thread);
+    pacing_set_serial_wake_fd(emulator_pipe[0]);
+    serial_bridge_on = 1;
+    return 0;
+}
+
+int serial_bridge_get(void)
+{
+    int was_full = !ring_space(&rx);
+    int c = ring_get(&rx);
+
+    if (was_full && c >= 0) {
+        wake_bridge();                // let the bridge read from the host again
+    }
+    return c;
+}
+
+int serial_bridge_put(uint8_t c)
+{
+    int was_empty = !ring_count(&tx);
+
+    if (ring_put(&tx, c)) {
+        return -1;
+    }
+    if (was_empty) {
+        wake_bridge();
+    }
+    return 0;
+}
+
+int serial_bridge_tx_ready(void)
+{
+    return ring_space(&tx) != 0;
+}
+#endif // WASM
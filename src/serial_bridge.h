@@ -0,0 +1,28 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Connects the I/O Box serial port to a host pseudo-terminal or Unix socket
+ * (terminal version only).
+ *
+ * A thread moves bytes between the host file descriptor and two ring
+ * buffers.  It only reads from the host while the receive ring has room, so
+ * when the firmware falls behind, the peer is held off by the kernel
+ * instead of bytes being dropped.
+ */
+
+#ifndef SERIAL_BRIDGE_H
+#define SERIAL_BRIDGE_H
+
+#include <stdint.h>
+
+// "pty" makes a pseudo-terminal and prints its name.  "unix:path" listens
+// on a Unix socket.  Returns -1 on error.
+int serial_bridge_open(const char *spec);
+
+extern int serial_bridge_on;
+
+int serial_bridge_get(void);             // next byte from the host, -1 if none
+int serial_bridge_put(uint8_t c);        // send a byte to the host, -1 if no room
+int serial_bridge_tx_ready(void);        // room to send
+
+#endif
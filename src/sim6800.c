@@ -38,7 +38,9 @@ int reset; /* User hit reset */
 int abrt; /* User hit abort (NMI) */
 int sp_stop;
 static int unsleep = 0;  /* signals an interrupt has happened */
+static int nmi_sp = -1;  /* stack pointer inside the NMI handler - its RTI can restore I set */
 uint32_t cycles_simulated_this_tick;  // updated by workslate_hw; used to simulate a certain number of cycles
+uint32_t sim_cycle_limit;             // what sim() was asked for, 0 = no limit
 
 /* CPU registers */
 unsigned char acca;
@@ -803,6 +805,7 @@ uint16_t highest_active_irq_vector(void)
 void sim(uint32_t cycles_to_simulate)
 {
     cycles_simulated_this_tick = 0;
+    sim_cycle_limit = cycles_to_simulate;
     while((cycles_to_simulate == 0) || (cycles_simulated_this_tick < cycles_to_simulate)) {
         unsigned char opcode;
         int org_trace_idx = trace_idx;
@@ -880,8 +883,10 @@ void sim(uint32_t cycles_to_simulate)
             push(acca, 'A');
             push(accb, 'B');
             push(read_flags(), 'F');
+            nmi_sp = sp;
             jump(mread2(0xFFFC));
-            printf("       NMI! to PC=%4.4X\n", pc);
+            if (trace)
+                printf("       NMI! to PC=%4.4X\n", pc);
             t->pc = pc;
             t->acca = acca;
             t->accb = accb;
@@ -893,6 +898,7 @@ void sim(uint32_t cycles_to_simulate)
             t->insn[2] = mread(pc + 2);
             t->ea = 0;
             t->data = 0;
+            unsleep = 1;  /* NMI wakes up SLP too (tape counter) */
         }
 
 //        if (intrpt) {  // is my reading of the hitachi manual correct?  That a masked interrupt wakes sleep?
@@ -1103,7 +1109,7 @@ void sim(uint32_t cycles_to_simulate)
                         break;
                     } case 0x8D: /* BSR REL */ {
                         push2(pc - 1, 'P');
-                        jump(t->ea = (pc - 1 + (char)mread(ea)));
+                        jump_subroutine(t->ea = (pc - 1 + (char)mread(ea)));
                         break;
                     } case 0x8E: case 0x9E: case 0xAE: case 0xBE: /* LDS N,Z,V */ {
                         sp = mread2(ea);
@@ -1126,7 +1132,7 @@ void sim(uint32_t cycles_to_simulate)
                             goto invalid16;
                         else {
                             push2(pc, 'P');
-                            jump(ea);
+                            jump_subroutine(ea);
                             t->ea = ea;
                         }
                         break;
@@ -1445,6 +1451,9 @@ invalid16:
                     } else {
                         pc--;         // repeat this instruction
                         trace_idx--;  // and don't put this sleep in the trace
+                        if (!test_any_irq_asserted() || i_flag) {
+                            cpu_sleeping();
+                        }
                     }
                     break;
 #endif
@@ -1599,8 +1608,13 @@ invalid16:
                     }
                     break;
                 } case 0x3B: /* RTI */ {
-                    write_flags(pull());
+                    if (sp == nmi_sp) {
+                        nmi_sp = -1;
+                        write_flags(pull());   // NMI can interrupt an ISR
+                    } else {
+                        write_flags(pull());
 if(i_flag) printf("Warning: IFLAG set from RTI\n");
+                    }
                     accb = pull();
                     acca = pull();
                     ix = pull2();
@@ -7,6 +7,7 @@ extern int reset;
 extern int abrt;    // 0 or 1, non-maskable
 extern int sp_stop;
 extern uint32_t cycles_simulated_this_tick;
+extern uint32_t sim_cycle_limit;    // 0 = none
 
 /* extern int brk; */
 extern int hasbrk;	/* JMR20201103 'brk' conflicts with unistd library. */
@@ -41,11 +42,13 @@ void show_traces(int n);
 /* Provided externally */
 
 void jump(unsigned short addr);
+void jump_subroutine(unsigned short addr);  // JSR/BSR, after pushing the return address
 unsigned char get_bank(void);
 unsigned char mread(unsigned short addr);
 unsigned char mread_raw(unsigned short addr); // like mread, but doesn't advance cycle
 void mwrite(unsigned short addr, unsigned char data);
 void monitor(void);
+void cpu_sleeping(void);  // called for each cycle spent in SLP (unless an interrupt is waking it)
 
 /* for stack tracing */
 char tagread(unsigned short addr);
@@ -0,0 +1,328 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "snapshot.h"
+
+int snapshot_on = 0;
+volatile sig_atomic_t snapshot_wanted = 0;
+
+/////////////////////////////
+// Renderer
+//
+// Each character row of the screen is 8 pixel rows.  The pixels of every row
+// of every glyph (and its inverse) are worked out once, so drawing a
+// character row is a 6 byte copy.
+
+static uint8_t glyph_rows[256][LCD_CHAR_HEIGHT][LCD_CHAR_WIDTH];
+static int glyphs_ready = 0;
+
+static void glyphs_init(void)
+{
+    for (int c = 0; c < 256; c++) {
+        for (int y = 0; y < LCD_CHAR_HEIGHT; y++) {
+            for (int x = 0; x < LCD_CHAR_WIDTH; x++) {
+                glyph_rows[c][y][x] = ((lcd_font[c & 0x7f][x] >> y) & 1) ^ (c >> 7);
+            }
+        }
+    }
+    glyphs_ready = 1;
+}
+
+void snapshot_render(const uint8_t *cells, uint8_t *pixels)
+{
+    if (!glyphs_ready) {
+        glyphs_init();
+    }
+    for (int row = 0; row < SNAP_ROWS; row++) {
+        const uint8_t *line = cells + row * SNAP_COLS;
+        for (int y = 0; y < LCD_CHAR_HEIGHT; y++) {
+            for (int col = 0; col < SNAP_COLS; col++) {
+                memcpy(pixels, glyph_rows[line[col]][y], LCD_CHAR_WIDTH);
+                pixels += LCD_CHAR_WIDTH;
+            }
+        }
+    }
+}
+
+#ifndef WASM
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "ring.h"
+
+/////////////////////////////
+// Snapshot writer
+//
+// snapshot_frame() only copies the display memory into a ring; the writer
+// thread renders and writes the file.  If the writer falls behind, snapshots
+// are skipped rather than holding up the emulator.
+
+#define SNAP_RING_SIZE  (1 << 16)
+
+struct snap {
+    uint64_t cycle;
+    uint32_t number;
+    uint8_t cells[SNAP_CELLS];
+};
+
+static uint8_t snap_buf[SNAP_RING_SIZE];
+static struct ring snaps;
+static char *base;              // path without the extension
+static const char *ext;
+static uint32_t snap_every = 0;
+static uint32_t frames = 0;
+static uint32_t number = 0;
+static int wake_pipe[2];
+static int quitting = 0;
+static pthread_t thread;
+
+static uint32_t crc_table[256];
+
+static void crc_init(void)
+{
+    for (uint32_t n = 0; n < 256; n++) {
+        uint32_t c = n;
+        for (int k = 0; k < 8; k++) {
+            c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+static uint32_t crc(uint32_t c, const uint8_t *p, uint32_t n)
+{
+    c = ~c;
+    while (n--) {
+        c = crc_table[(c ^ *p++) & 0xFF] ^ (c >> 8);
+    }
+    return ~c;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static void png_chunk(FILE *f, const char *type, const uint8_t *data, uint32_t n)
+{
+    uint8_t b[8];
+
+    put32(b, n);
+    memcpy(b + 4, type, 4);
+    fwrite(b, 1, 8, f);
+    fwrite(data, 1, n, f);
+    put32(b, crc(crc(0, b + 4, 4), data, n));
+    fwrite(b, 1, 4, f);
+}
+
+// 1 bit per pixel palette PNG.  The image is tiny, so it goes in a single
+// uncompressed deflate block and we don't need zlib.
+static void write_png(FILE *f, const uint8_t *pixels, uint64_t cycle)
+{
+    enum { STRIDE = 1 + (SNAP_WIDTH + 7) / 8, RAW = STRIDE * SNAP_HEIGHT };
+    static uint8_t z[2 + 5 + RAW + 4];
+    uint8_t hdr[13] = { 0 };
+    uint8_t plte[6] = {
+        (LCD_RGB_OFF >> 16) & 0xFF, (LCD_RGB_OFF >> 8) & 0xFF, LCD_RGB_OFF & 0xFF,
+        (LCD_RGB_ON >> 16) & 0xFF, (LCD_RGB_ON >> 8) & 0xFF, LCD_RGB_ON & 0xFF };
+    uint8_t *raw = z + 7;
+    uint32_t a = 1, b = 0;
+    char text[64];
+    int n;
+
+    fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+    put32(hdr, SNAP_WIDTH);
+    put32(hdr + 4, SNAP_HEIGHT);
+    hdr[8] = 1;       // bit depth
+    hdr[9] = 3;       // palette
+    png_chunk(f, "IHDR", hdr, sizeof(hdr));
+    png_chunk(f, "PLTE", plte, sizeof(plte));
+    n = snprintf(text, sizeof(text), "Comment%ccycle %llu", 0, (unsigned long long) cycle);
+    png_chunk(f, "tEXt", (uint8_t *) text, n);
+
+    memset(raw, 0, RAW);
+    for (int y = 0; y < SNAP_HEIGHT; y++) {
+        uint8_t *r = raw + y * STRIDE + 1;     // after the filter type (0=none)
+        for (int x = 0; x < SNAP_WIDTH; x++) {
+            r[x >> 3] |= *pixels++ << (7 - (x & 7));
+        }
+    }
+    for (int i = 0; i < RAW; i++) {
+        a = (a + raw[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    z[0] = 0x78;      // zlib header: deflate, no preset dictionary
+    z[1] = 0x01;
+    z[2] = 1;         // final block, stored
+    z[3] = RAW & 0xFF;
+    z[4] = RAW >> 8;
+    z[5] = ~RAW & 0xFF;
+    z[6] = (~RAW >> 8) & 0xFF;
+    put32(z + 7 + RAW, (b << 16) | a);
+    png_chunk(f, "IDAT", z, sizeof(z));
+    png_chunk(f, "IEND", NULL, 0);
+}
+
+static void write_ppm(FILE *f, const uint8_t *pixels, uint64_t cycle)
+{
+    fprintf(f, "P6\n# cycle %llu\n%d %d\n255\n", (unsigned long long) cycle, SNAP_WIDTH, SNAP_HEIGHT);
+    for (int i = 0; i < SNAP_WIDTH * SNAP_HEIGHT; i++) {
+        uint32_t rgb = pixels[i] ? LCD_RGB_ON : LCD_RGB_OFF;
+        fputc(rgb >> 16, f);
+        fputc((rgb >> 8) & 0xFF, f);
+        fputc(rgb & 0xFF, f);
+    }
+}
+
+int snapshot_write(const char *name, const uint8_t *cells, uint64_t cycle)
+{
+    static uint8_t pixels[SNAP_WIDTH * SNAP_HEIGHT];
+    const char *dot = strrchr(name, '.');
+    FILE *f;
+
+    if (!crc_table[1]) {
+        crc_init();
+    }
+    snapshot_render(cells, pixels);
+    f = fopen(name, "wb");
+    if (!f) {
+        perror(name);
+        return -1;
+    }
+    if (dot && !strcmp(dot, ".ppm")) {
+        write_ppm(f, pixels, cycle);
+    } else {
+        write_png(f, pixels, cycle);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void write_snap(const struct snap *s)
+{
+    char name[1024];
+
+    snprintf(name, sizeof(name), "%s%05u%s", base, s->number, ext);
+    snapshot_write(name, s->cells, s->cycle);
+}
+
+static void *snap_thread(void *arg)
+{
+    struct snap s;
+    struct pollfd p;
+    char junk[64];
+
+    for (;;) {
+        while (ring_count(&snaps) >= sizeof(s)) {
+            ring_peek(&snaps, &s, sizeof(s));
+            ring_drop(&snaps, sizeof(s));
+            write_snap(&s);
+        }
+        if (__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) {
+            return NULL;
+        }
+        p.fd = wake_pipe[0];
+        p.events = POLLIN;
+        poll(&p, 1, -1);
+        while (read(wake_pipe[0], junk, sizeof(junk)) == sizeof(junk))
+            ;
+    }
+}
+
+static void wake_writer(void)
+{
+    char c = 0;
+
+    if (write(wake_pipe[1], &c, 1) < 0) {
+        // pipe already full, so a wakeup is pending anyway
+    }
+}
+
+// Write out the snapshots already taken before we exit
+static void snapshot_close(void)
+{
+    __atomic_store_n(&quitting, 1, __ATOMIC_RELEASE);
+    wake_writer();
+    pthread_join(thread, NULL);
+}
+
+static void on_sigusr1(int sig)
+{
+    snapshot_wanted = 1;
+}
+
+int snapshot_open(const char *path, uint32_t every)
+{
+    const char *dot = strrchr(path, '.');
+
+    if (!dot || (strcmp(dot, ".png") && strcmp(dot, ".ppm"))) {
+        printf("Snapshot file name must end in .png or .ppm\n");
+        return -1;
+    }
+    base = strndup(path, dot - path);
+    ext = dot;
+    snap_every = every;
+
+    crc_init();
+    ring_init(&snaps, snap_buf, SNAP_RING_SIZE);
+    if (pipe(wake_pipe)) {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&thread, NULL, snap_thread, NULL)) {
+        printf("Can't start snapshot thread\n");
+        return -1;
+    }
+    atexit(snapshot_close);
+    signal(SIGUSR1, on_sigusr1);
+    snapshot_on = 1;
+    return 0;
+}
+
+void snapshot_frame(const uint8_t *cells, uint64_t cycle)
+{
+    struct snap s;
+
+    frames++;
+    if (!snapshot_wanted && !(snap_every && frames % snap_every == 0)) {
+        return;
+    }
+    snapshot_wanted = 0;
+    number++;
+    if (ring_space(&snaps) < sizeof(s)) {
+        return;    // writer is behind - skip this one
+    }
+    s.cycle = cycle;
+    s.number = number;
+    memcpy(s.cells, cells, SNAP_CELLS);
+    ring_write(&snaps, &s, sizeof(s));
+    wake_writer();
+}
+#endif // WASM
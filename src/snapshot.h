@@ -0,0 +1,45 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * LCD screenshots (terminal version only).
+ *
+ * snapshot_render() draws the 46x16 character screen into a 276x128 pixel
+ * framebuffer with the real font, without needing a terminal.  Snapshots are
+ * taken every N LCD frames, or on request (SIGUSR1), and written as PNG or
+ * PPM files by a background thread, so they don't slow the emulation down.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdint.h>
+#include <signal.h>
+
+#include "lcd_font.h"
+
+#define SNAP_COLS     46
+#define SNAP_ROWS     16
+#define SNAP_CELLS    (SNAP_COLS * SNAP_ROWS)
+#define SNAP_WIDTH    (SNAP_COLS * LCD_CHAR_WIDTH)     // 276
+#define SNAP_HEIGHT   (SNAP_ROWS * LCD_CHAR_HEIGHT)    // 128
+
+// One byte per pixel: 1=lit, 0=not
+void snapshot_render(const uint8_t *cells, uint8_t *pixels);
+
+// path is like "shots/screen.png" (or .ppm); the snapshot number goes before
+// the extension: shots/screen00001.png.  every = LCD frames between snapshots,
+// 0 for only on request.  -1 on error
+int snapshot_open(const char *path, uint32_t every);
+
+extern int snapshot_on;
+extern volatile sig_atomic_t snapshot_wanted;   // set to take one at the next frame (SIGUSR1)
+
+// Called once per LCD frame with the display memory.  The cycle is noted in
+// the file (a PNG comment, or a PPM header comment)
+void snapshot_frame(const uint8_t *cells, uint64_t cycle);
+
+// Write one snapshot now, as PPM if the name ends in .ppm, otherwise PNG.
+// Used by the writer thread, and by tools/lcdplay.  -1 on error
+int snapshot_write(const char *name, const uint8_t *cells, uint64_t cycle);
+
+#endif
@@ -0,0 +1,217 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "spooler.h"
+
+int spooler_on = 0;
+
+#ifndef WASM
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "ring.h"
+
+/////////////////////////////
+// Print spooler
+//
+// The emulator only puts bytes into a ring; all file I/O is done by the
+// writer thread, so printing doesn't slow the emulated CPU down.  The thread
+// is woken through a pipe when the ring stops being empty.
+//
+// Idle gaps are timed by the emulator, which puts a mark in the stream
+// where a job ends: SPOOL_MARK is followed by 0 for the end of a job, or by
+// another SPOOL_MARK for a real SPOOL_MARK byte.
+
+#define SPOOL_RING_SIZE   (1 << 20)
+#define SPOOL_CHUNK       4096
+#define SPOOL_MARK        0xFF
+
+static uint8_t spool_buf[SPOOL_RING_SIZE];
+static struct ring spool;
+
+static const char *spool_dir;
+static FILE *job = NULL;              // job being written
+static int job_number = 0;
+static int wake_pipe[2];
+static int quitting = 0;
+static pthread_t thread;
+
+// emulator side
+static int printing = 0;              // bytes sent since the last end of job
+static uint64_t last_put;             // msec
+
+static void wake_writer(void)
+{
+    char c = 0;
+
+    if (write(wake_pipe[1], &c, 1) < 0) {
+        // pipe already full, so a wakeup is pending anyway
+    }
+}
+
+static void write_job(const uint8_t *data, uint32_t n)
+{
+    char name[1024];
+
+    if (!n) {
+        return;
+    }
+    while (!job) {
+        snprintf(name, sizeof(name), "%s/print%03d.txt", spool_dir, ++job_number);
+        if (access(name, F_OK) == 0) {
+            continue;    // don't overwrite earlier jobs
+        }
+        job = fopen(name, "wb");
+        if (!job) {
+            perror(name);
+            return;
+        }
+    }
+    fwrite(data, 1, n, job);
+}
+
+static void end_job(void)
+{
+    if (job) {
+        fclose(job);
+        job = NULL;
+    }
+}
+
+static void *spool_thread(void *arg)
+{
+    uint8_t chunk[SPOOL_CHUNK];
+    struct pollfd p;
+    uint32_t n, i, start;
+    int marked = 0;                   // last byte was a SPOOL_MARK
+
+    for (;;) {
+        if (!ring_count(&spool) && !__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) {
+            p.fd = wake_pipe[0];
+            p.events = POLLIN;
+            poll(&p, 1, -1);
+            while (read(wake_pipe[0], chunk, sizeof(chunk)) == sizeof(chunk))
+                ;
+        }
+
+        n = ring_peek(&spool, chunk, sizeof(chunk));
+        if (!n) {
+            if (__atomic_load_n(&quitting, __ATOMIC_ACQUIRE)) {
+                end_job();
+                return NULL;
+            }
+            continue;
+        }
+        ring_drop(&spool, n);
+        for (start = 0, i = 0; i < n; i++) {
+            if (marked) {
+                marked = 0;
+                if (chunk[i] != SPOOL_MARK) {
+                    end_job();        // printer went quiet
+                    start = i + 1;
+                }                     // else a real SPOOL_MARK starts the next run
+                continue;
+            }
+            if (chunk[i] == SPOOL_MARK) {
+                write_job(chunk + start, i - start);
+                marked = 1;
+                start = i + 1;
+                continue;
+            }
+            if (chunk[i] == '\f') {    // form feed ends the job (and stays with it)
+                write_job(chunk + start, i + 1 - start);
+                end_job();
+                start = i + 1;
+            }
+        }
+        write_job(chunk + start, n - start);
+    }
+}
+
+// Finish writing whatever has been printed before we exit
+static void spooler_close(void)
+{
+    __atomic_store_n(&quitting, 1, __ATOMIC_RELEASE);
+    wake_writer();
+    pthread_join(thread, NULL);
+}
+
+int spooler_open(const char *dir)
+{
+    spool_dir = dir;
+    ring_init(&spool, spool_buf, SPOOL_RING_SIZE);
+    if (pipe(wake_pipe)) {
+        perror("pipe");
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&thread, NULL, spool_thread, NULL)) {
+        printf("Can't start print spooler thread\n");
+        return -1;
+    }
+    atexit(spooler_close);
+    spooler_on = 1;
+    return 0;
+}
+
+static void put_bytes(const uint8_t *b, uint32_t n)
+{
+    int was_empty = !ring_count(&spool);
+
+    ring_write(&spool, b, n);
+    if (was_empty) {
+        wake_writer();
+    }
+}
+
+void spooler_tick(uint64_t now)
+{
+    static const uint8_t end[2] = { SPOOL_MARK, 0 };
+
+    if (printing && now - last_put >= SPOOL_IDLE_MSEC) {
+        put_bytes(end, 2);
+        printing = 0;
+    }
+}
+
+int spooler_put(uint8_t c, uint64_t now)
+{
+    uint8_t b[2] = { c, c };
+
+    if (!spooler_ready()) {
+        return -1;
+    }
+    spooler_tick(now);    // a long gap before this byte ends the last job
+    put_bytes(b, c == SPOOL_MARK ? 2 : 1);
+    printing = 1;
+    last_put = now;
+    return 0;
+}
+
+int spooler_ready(void)
+{
+    return ring_space(&spool) >= 4;    // an end of job mark and an escaped byte
+}
+#endif // WASM
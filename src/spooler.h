@@ -0,0 +1,28 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Print spooler (terminal version only).
+ *
+ * Collects what the firmware sends out of the serial port and writes it to
+ * files from a background thread, one file per print job.  A job ends at a
+ * form feed, or when nothing has been sent for SPOOL_IDLE_MSEC of emulated
+ * time, so the same printout always splits the same way at any --speed.
+ */
+
+#ifndef SPOOLER_H
+#define SPOOLER_H
+
+#include <stdint.h>
+
+#define SPOOL_IDLE_MSEC   2000
+
+int spooler_open(const char *dir);       // jobs go to dir/print001.txt, ...  -1 on error
+
+extern int spooler_on;
+
+// 'now' is the emulated time in msec
+int spooler_put(uint8_t c, uint64_t now);   // -1 if the spooler is full
+int spooler_ready(void);                 // room for another byte
+void spooler_tick(uint64_t now);         // now and then, to end a job that has gone quiet
+
+#endif
@@ -0,0 +1,459 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifndef WASM
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "tape.h"
+#include "pacing.h"
+
+/////////////////////////////
+// Microcassette transport
+//
+// Worked out from the u16 firmware, so the bit meanings are educated guesses:
+//
+// CSTAPE0 write (the firmware keeps a shadow copy at $054D):
+//   0x03  reel motor: 0=stop, 1=rewind, 2=play, 3=fast forward.  The firmware
+//         sets the counting direction at $055A to match (-1 for rewind).
+//   0x0C  mode cam motor: 0x08 runs it, 0x00/0x04 stop it.  The firmware runs
+//         it until the cam switch changes state (C6EF, C706), to move the
+//         head between stop and play.
+//   0x80  record
+// CSTAPE0 read:
+//   0x01  NMI is not from the tape.  The NMI handler (C335) only counts when 0
+//   0x02  cam switch
+//   0x04  1=no tape
+//   0x08  1=can record
+//
+// Each tick of the position counter sends an NMI, which the handler adds to
+// the counter at $0222.  Winding runs TAPE_WIND_SPEED times play speed.
+
+#define TAPE_MAGIC        "WSTAPE1\n"
+#define TAPE_WIND_SPEED   8                  // samples per sample time when winding
+#define TAPE_CAM_CYCLES   122880             // cam switch changes state every 100 msec
+#define TAPE_FAST_CAM_CYCLES  256
+
+enum { MOTOR_STOP, MOTOR_REWIND, MOTOR_PLAY, MOTOR_FFWD };
+
+int tape_fast = 0;
+int tape_active = 0;
+
+static int loaded = 0;                 // a tape is in the drive
+static uint8_t *image = NULL;          // mapped image file
+static size_t image_size;
+static FILE *hl_file = NULL;           // high-level tape file (instead of an image)
+static int hl_writing = -1;            // last transfer was a put (1) or a get (0), -1 after opening
+static uint32_t hl_ticks = 0;          // position ticks the bytes moved the head, not yet sent
+static uint32_t hl_quiet = 0;          // sample times since the last byte put, 0 once written out
+static uint64_t tape_samples;          // length of tape
+static int write_protected;
+static uint64_t position = 0;          // head position, in samples (survives reset, like a real tape)
+static uint32_t sample_phase = 0;      // cycles into the current sample
+static int motor, cam, record;
+static int cam_switch;
+static uint32_t cam_cycles;            // cycles until the cam switch changes state
+static int in_level = 0;               // playback signal
+
+#ifndef WASM
+static void hl_flush(void);
+#endif
+
+static void update_active(void)
+{
+    tape_active = (motor != MOTOR_STOP && loaded) || cam == 0x08;
+#ifndef WASM
+    pacing_set_turbo(tape_fast && tape_active);
+#endif
+}
+
+static int read_sample(uint64_t pos)
+{
+    if (!image || pos >= tape_samples) {
+        return 0;
+    }
+    return (image[TAPE_HEADER_SIZE + pos / 8] >> (pos & 7)) & 1;
+}
+
+static void write_sample(uint64_t pos, int level)
+{
+    uint8_t mask = 1 << (pos & 7);
+
+    if (image && pos < tape_samples) {
+        uint8_t *p = &image[TAPE_HEADER_SIZE + pos / 8];
+        *p = level ? (*p | mask) : (*p & ~mask);
+    }
+}
+
+// One sample time of tape movement
+static int tape_step(int out_level)
+{
+    uint64_t old = position;
+    uint64_t wind = tape_fast ? TAPE_TICK_SAMPLES : TAPE_WIND_SPEED;
+    int ev = 0;
+    int level;
+
+    switch (motor) {
+        case MOTOR_PLAY:
+            if (position >= tape_samples) {
+                return 0;     // end of tape - motor stalls
+            }
+            if (record && !write_protected) {
+                write_sample(position, out_level);
+            }
+            position++;
+            level = read_sample(position);
+            if (level != in_level) {
+                in_level = level;
+                ev |= TAPE_EV_EDGE;
+            }
+            break;
+        case MOTOR_FFWD:
+            position = (position + wind < tape_samples) ? position + wind : tape_samples;
+            break;
+        case MOTOR_REWIND:
+            position = (position > wind) ? position - wind : 0;
+            break;
+    }
+    if (old / TAPE_TICK_SAMPLES != position / TAPE_TICK_SAMPLES) {
+        ev |= TAPE_EV_TICK;
+    }
+    return ev;
+}
+
+int tape_clock(uint32_t cycles, int out_level)
+{
+    int ev = 0;
+
+    if (cam == 0x08) {
+        if (cycles >= cam_cycles) {
+            cam_switch = !cam_switch;
+            cam_cycles = tape_fast ? TAPE_FAST_CAM_CYCLES : TAPE_CAM_CYCLES;
+        } else {
+            cam_cycles -= cycles;
+        }
+    }
+    if (motor != MOTOR_STOP && loaded) {
+        sample_phase += cycles;
+        if (sample_phase >= TAPE_SAMPLE_CYCLES) {
+            sample_phase -= TAPE_SAMPLE_CYCLES;
+            ev |= tape_step(out_level);
+            if (hl_ticks && !(ev & TAPE_EV_TICK)) {
+                hl_ticks--;
+                ev |= TAPE_EV_TICK;
+            }
+#ifndef WASM
+            if (hl_quiet && ++hl_quiet > TAPE_TICK_SAMPLES) {
+                hl_flush();
+            }
+#endif
+        }
+    }
+    return ev;
+}
+
+// Cycles until tape_clock() might return an event or change tape_status()
+uint32_t tape_cycles_until_next_event(void)
+{
+    uint32_t n = 0xFFFFFFFF;
+
+    if (cam == 0x08) {
+        n = cam_cycles;
+    }
+    if (motor != MOTOR_STOP && loaded && TAPE_SAMPLE_CYCLES - sample_phase < n) {
+        n = TAPE_SAMPLE_CYCLES - sample_phase;
+    }
+    return n;
+}
+
+int tape_in_level(void)
+{
+    return in_level;
+}
+
+uint8_t tape_status(void)
+{
+    uint8_t s = 0;
+
+    if (cam_switch) {
+        s |= 0x02;
+    }
+    if (!loaded) {
+        s |= 0x04;
+    } else if (!write_protected) {
+        s |= 0x08;
+    }
+    return s;
+}
+
+void tape_control(uint8_t data)
+{
+    if ((data & 0x0C) == 0x08 && cam != 0x08) {
+        cam_cycles = tape_fast ? TAPE_FAST_CAM_CYCLES : TAPE_CAM_CYCLES;
+    }
+    motor = data & 0x03;
+    cam = data & 0x0C;
+    record = data & 0x80;
+    update_active();
+}
+
+void tape_reset(void)
+{
+    motor = MOTOR_STOP;
+    cam = 0;
+    record = 0;
+    cam_switch = 0;
+    sample_phase = 0;
+    update_active();
+}
+
+/////////////////////////////
+// Image file
+//
+// The image is mapped rather than read in, so only the parts of the tape that
+// get played are loaded, and recordings go straight back to the file.
+
+#ifndef WASM
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+// Make sure the tape is written back when we exit
+static void register_eject(void)
+{
+    static int registered = 0;
+
+    if (!registered) {
+        registered = 1;
+        atexit(tape_eject);
+    }
+}
+
+int tape_insert(const char *filename)
+{
+    uint8_t hdr[TAPE_HEADER_SIZE];
+    struct stat st;
+    uint32_t ticks;
+    int writable = 1;
+    int fd;
+
+    tape_eject();
+    fd = open(filename, O_RDWR | O_CREAT, 0666);
+    if (fd < 0) {
+        writable = 0;
+        fd = open(filename, O_RDONLY);
+    }
+    if (fd < 0 || fstat(fd, &st)) {
+        perror(filename);
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+
+    if (st.st_size == 0 && writable) {   // new blank tape
+        memset(hdr, 0, sizeof(hdr));
+        memcpy(hdr, TAPE_MAGIC, 8);
+        put_le32(hdr + 8, TAPE_DEFAULT_TICKS);
+        if (write(fd, hdr, sizeof(hdr)) != sizeof(hdr)
+            || ftruncate(fd, TAPE_HEADER_SIZE + (off_t) TAPE_DEFAULT_TICKS * TAPE_TICK_BYTES)
+            || fstat(fd, &st)) {
+            perror(filename);
+            close(fd);
+            return -1;
+        }
+    }
+
+    if (pread(fd, hdr, sizeof(hdr), 0) != sizeof(hdr) || memcmp(hdr, TAPE_MAGIC, 8)) {
+        printf("%s is not a tape image\n", filename);
+        close(fd);
+        return -1;
+    }
+    ticks = get_le32(hdr + 8);
+    if ((uint64_t) st.st_size < TAPE_HEADER_SIZE + (uint64_t) ticks * TAPE_TICK_BYTES) {
+        printf("Tape image %s is truncated\n", filename);
+        close(fd);
+        return -1;
+    }
+
+    image_size = st.st_size;
+    image = (uint8_t *) mmap(NULL, image_size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                             MAP_SHARED, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        perror(filename);
+        image = NULL;
+        return -1;
+    }
+    madvise(image, image_size, MADV_SEQUENTIAL);
+
+    tape_samples = (uint64_t) ticks * TAPE_TICK_SAMPLES;
+    write_protected = !writable || (get_le32(hdr + 12) & 1);
+    position = 0;    // a tape always goes in rewound
+    in_level = read_sample(0);
+    loaded = 1;
+    update_active();
+    register_eject();
+    return 0;
+}
+
+/////////////////////////////
+// High-level tape
+//
+// The tape is a plain host file holding the byte stream the firmware's serial
+// driver sends to the tape channel.  workslate_hw.c intercepts the driver and
+// calls tape_hl_put() and tape_hl_get(), so no bits go over the (emulated)
+// tape at all.  The stream is kept in step with the tape counter: the first
+// byte after the channel is opened goes TAPE_HL_BYTES_PER_TICK bytes per
+// position tick into the file, so a worksheet is read back from where it was
+// saved.  (Not at the open itself: the firmware opens the channel before it
+// winds to the start.)  Each byte moves the head on by its share of a tick,
+// so the next save starts after this one, and the ticks it crosses are sent
+// one per sample time while the motor runs, as winding does, so the
+// firmware's counter keeps up.  In between, the bytes just go through stdio's
+// buffer.
+
+int tape_hl_insert(const char *filename)
+{
+    tape_eject();
+    hl_file = fopen(filename, "r+b");
+    if (!hl_file) {
+        hl_file = fopen(filename, "w+b");
+    }
+    if (!hl_file) {
+        perror(filename);
+        return -1;
+    }
+    tape_samples = (uint64_t) TAPE_DEFAULT_TICKS * TAPE_TICK_SAMPLES;
+    write_protected = 0;
+    position = 0;
+    in_level = 0;
+    loaded = 1;
+    tape_fast = 1;    // don't wait for the mechanism either
+    update_active();
+    register_eject();
+    return 0;
+}
+
+int tape_hl_active(void)
+{
+    return hl_file != NULL;
+}
+
+void tape_hl_seek(void)
+{
+    hl_writing = -1;
+}
+
+// The byte went over the head
+static void hl_move(void)
+{
+    uint64_t old = position;
+
+    position += TAPE_TICK_SAMPLES / TAPE_HL_BYTES_PER_TICK;
+    if (position > tape_samples) {
+        position = tape_samples;
+    }
+    if (old / TAPE_TICK_SAMPLES != position / TAPE_TICK_SAMPLES) {
+        hl_ticks++;
+    }
+}
+
+// Seek to the head position for the first byte, and between reading and
+// writing, as stdio needs.  A seek also writes out what was put.
+static int hl_seek(int writing)
+{
+    int err = 0;
+
+    if (hl_writing < 0) {
+        err = fseek(hl_file, (long) (position / TAPE_TICK_SAMPLES) * TAPE_HL_BYTES_PER_TICK, SEEK_SET);
+        hl_quiet = 0;
+    } else if (hl_writing != writing) {
+        err = fseek(hl_file, 0, SEEK_CUR);
+        hl_quiet = 0;
+    }
+    hl_writing = writing;
+    return err;
+}
+
+// Returns -1 on a write error, after ejecting the tape
+int tape_hl_put(uint8_t c)
+{
+    if (hl_seek(1) || fputc(c, hl_file) == EOF) {
+        perror("High-level tape");
+        tape_eject();
+        return -1;
+    }
+    hl_move();
+    hl_quiet = 1;
+    return 0;
+}
+
+// The firmware leaves the motor running after a save, so once the bytes stop
+// for a tick, the save is written out
+static void hl_flush(void)
+{
+    hl_quiet = 0;
+    if (fflush(hl_file)) {
+        perror("High-level tape");
+        tape_eject();
+    }
+}
+
+// Returns -1 at the end of the recording
+int tape_hl_get(void)
+{
+    int c;
+
+    if (hl_seek(0) || (c = fgetc(hl_file)) == EOF) {
+        return -1;
+    }
+    hl_move();
+    return c;
+}
+
+void tape_eject(void)
+{
+    if (image) {
+        msync(image, image_size, MS_SYNC);
+        munmap(image, image_size);
+        image = NULL;
+    }
+    if (hl_file) {
+        if (fclose(hl_file)) {   // the last bytes are written here
+            perror("High-level tape");
+        }
+        hl_file = NULL;
+    }
+    hl_ticks = 0;
+    hl_quiet = 0;
+    loaded = 0;
+    update_active();
+}
+#endif // WASM
@@ -0,0 +1,61 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * Built-in microcassette drive.
+ *
+ * The drive is controlled through the tape PLA (CSTAPE0 at 0x2C).  It sends
+ * an NMI for every tick of the tape position counter, and the playback signal
+ * goes to the timer's input capture pin (P20).  When recording, the signal
+ * is taken from P21 (the output compare pin).
+ *
+ * Tape image file format (little endian):
+ *
+ *   0   8 bytes   "WSTAPE1\n"
+ *   8   uint32    length of the tape in position ticks
+ *   12  uint32    flags: bit 0 = write protected
+ *   16  48 bytes  reserved, 0
+ *   64  data      TAPE_TICK_BYTES per tick.  The signal is sampled every
+ *                 TAPE_SAMPLE_CYCLES E cycles, one bit per sample, LSB first.
+ *
+ * New images are created sparse, so blank tape takes no disk space.
+ */
+
+#ifndef TAPE_H
+#define TAPE_H
+
+#include <stdint.h>
+
+#define TAPE_HEADER_SIZE     64
+#define TAPE_SAMPLE_CYCLES   64                     // 19200 samples/sec
+#define TAPE_TICK_SAMPLES    1200                   // 16 position ticks/sec at play speed
+#define TAPE_TICK_BYTES      (TAPE_TICK_SAMPLES / 8)
+#define TAPE_DEFAULT_TICKS   (16 * 60 * 15)         // 15 minutes per side (MC-30)
+
+// tape_clock() events
+#define TAPE_EV_TICK   0x01   // position counter tick - send NMI
+#define TAPE_EV_EDGE   0x02   // playback signal changed (see tape_in_level())
+
+int tape_insert(const char *filename);   // map image file, creating it if needed.  -1 on error
+void tape_eject(void);
+extern int tape_fast;                    // skip mechanical delays and run unthrottled while the tape moves
+
+// High-level tape: a host file with the firmware's tape byte stream (see tape.c)
+#define TAPE_HL_BYTES_PER_TICK   8
+int tape_hl_insert(const char *filename);   // -1 on error
+int tape_hl_active(void);
+void tape_hl_seek(void);                 // tape channel opened - start at the head position at the first byte
+int tape_hl_put(uint8_t c);              // -1 on a write error (the tape is ejected)
+int tape_hl_get(void);                   // -1 at the end of the recording
+
+// PLA interface
+uint8_t tape_status(void);               // CSTAPE0 read bits
+void tape_control(uint8_t data);         // CSTAPE0 write
+void tape_reset(void);
+
+// Called by the hardware code every cycle while tape_active is set
+extern int tape_active;
+int tape_clock(uint32_t cycles, int out_level);   // returns TAPE_EV_* bits
+uint32_t tape_cycles_until_next_event(void);
+int tape_in_level(void);
+
+#endif
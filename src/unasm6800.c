@@ -28,6 +28,12 @@
 struct fact *swi_facts;
 int targets[65536];
 struct fact *facts[65536];
+int facts_end = 0x10000;	/* facts at or past here don't describe the code being unassembled */
+
+static struct fact *fact_at(int addr)
+{
+	return addr < facts_end ? facts[addr] : 0;
+}
 
 struct fact *mkfact(unsigned short addr, int type, int len, char *label, char *comment)
 {
@@ -121,7 +127,7 @@ int fcb_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int flag)
 	struct fact *fact;
 	int flg = targets[pc];
 	sprintf(buf, "%4.4X: %2.2X ", pc, mem[pc]);
-	fact = facts[pc];
+	fact = fact_at(pc);
 	pc++;
 	if (fact) {
 		sprintf(buf1, "%-10s FCB $%2.2X", fact->label, mem[pc - 1]);
@@ -145,7 +151,7 @@ int rmb_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int flag,
 	struct fact *fact;
 	int flg = targets[pc];
 	sprintf(buf, "%4.4X: %2.2X ", pc, mem[pc]);
-	fact = facts[pc];
+	fact = fact_at(pc);
 	pc += len;
 	if (fact) {
 		sprintf(buf1, "%-10s RMB %d", fact->label, len);
@@ -169,7 +175,7 @@ int fcc_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int flag,
 	struct fact *fact;
 	int flg = targets[pc];
 	sprintf(buf, "%4.4X: %2.2X ", pc, mem[pc]);
-	fact = facts[pc];
+	fact = fact_at(pc);
 	pc += len;
 	if (fact) {
 		sprintf(buf1, "%-10s FCC %d", fact->label, len);
@@ -193,7 +199,7 @@ int fdb_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int flag)
 	struct fact *fact;
 	int flg = targets[pc];
 	sprintf(buf, "%4.4X: %2.2X %2.X", pc, mem[pc], mem[pc+1]);
-	fact = facts[pc];
+	fact = fact_at(pc);
 	pc += 2;
 	if (fact) {
 		sprintf(buf1, "%-10s FDB $%4.4X", fact->label, (((int)mem[pc - 2] << 8) + mem[pc -1]));
@@ -236,7 +242,7 @@ void unasm_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int *at
 
 	pc = *at_pc;
 	flg = targets[pc];
-	fact = facts[pc];
+	fact = fact_at(pc);
 
 	insn = "???";
 	sprintf(buf,"%4.4X: ", pc);
@@ -766,7 +772,7 @@ invalidinh:
 	if (ea_fact == -1 && (branch_target >= 0 && branch_target <= 0xFFFF))
 	        ea_fact = branch_target;
 	if (ea_fact != -1) {
-	        struct fact *f = facts[ea_fact];
+	        struct fact *f = fact_at(ea_fact);
 	        if (f) {
 	                sprintf(buf1 + strlen(buf1)," [%s %s]", f->label,f->comment);
 	        }
@@ -780,7 +786,7 @@ invalidinh:
                 if (f) {
                         sprintf(outbuf + strlen(outbuf), " (%s    %s)",f->label,f->comment);
                 }
-	} else if (branch_target > 0 && branch_target < 0x10000 && facts[branch_target]) {
+	} else if (branch_target > 0 && branch_target < 0x10000 && fact_at(branch_target)) {
 	        /* sprintf(outbuf + strlen(outbuf), " (to %s [%s])", facts[branch_target]->label, facts[branch_target]->comment); */
 	} else if (branch_target > 0 && branch_target < 0x10000 && targets[branch_target])
 		sprintf(outbuf + strlen(outbuf), " (to L%4.4d)", targets[branch_target]);
@@ -11,6 +11,7 @@ struct fact {
 
 extern int targets[65536];
 extern struct fact *facts[65536];
+extern int facts_end;
 
 void unasm_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int *at_target, int flag);
 int fdb_line(unsigned char *mem, unsigned short *at_pc, char *outbuf, int flag);
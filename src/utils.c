@@ -218,6 +218,33 @@ int parse_dec(char **at_p, int *dec)
 	}
 }
 
+/* Bytes the keyboard reader had already read from stdin when the monitor
+ * took over.  jgetline() reads these first.
+ */
+
+static char unread_buf[256];
+static int unread_len, unread_pos;
+
+void unread_stdin(const char *buf, int n)
+{
+        if (n > (int) sizeof(unread_buf) - unread_len)
+                n = sizeof(unread_buf) - unread_len;
+        memcpy(unread_buf + unread_len, buf, n);
+        unread_len += n;
+}
+
+/* Take back what jgetline() didn't use */
+
+int take_unread_stdin(char *buf, int max)
+{
+        int n = unread_len - unread_pos;
+        if (n > max)
+                n = max;
+        memcpy(buf, unread_buf + unread_pos, n);
+        unread_pos = unread_len = 0;
+        return n;
+}
+
 /* Get input line with editing (for when cooked is off).
  * Returns -1 if Ctrl-C hit
  */
@@ -238,7 +265,9 @@ int jgetline(FILE *f, char *buf)
         fflush(stdout);
         for (;;) {
                 char c;
-                if (read(fileno(stdin), &c, 1) < 0)
+                if (unread_pos < unread_len)
+                        c = unread_buf[unread_pos++];
+                else if (read(fileno(stdin), &c, 1) < 0)
                         return -1;
                 if (c == 8 || c == 127) {
                         if (x) {
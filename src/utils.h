@@ -8,6 +8,8 @@ int parse_hex4(char **at_p, int *hex);
 int parse_dec(char **at_p, int *dec);
 
 int jgetline(FILE *f, char *buf);
+void unread_stdin(const char *buf, int n);      // give jgetline() bytes read ahead
+int take_unread_stdin(char *buf, int max);      // and take back what it didn't use
 int hatoi(unsigned char *buf);
 void hd(FILE *out, unsigned char *mem, int start, int len);  // assumes memory is in RAM
 void hd2(FILE *out, int start, int len);  // uses mread to also read registers
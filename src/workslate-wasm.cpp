@@ -1,7 +1,12 @@
 #include <cheerp/clientlib.h>
 #include <cheerp/client.h>
 #include <cheerpfs.h>
+#include <stdlib.h>
 #include "sim6800.h"
+#include "lcd_font.h"
+#include "frame_sched.h"
+#include "lcd_watch.h"
+#include "workslate.h"
 
 static const int lcd_base_x = 54+6;    // upper left corner
 static const int lcd_base_y = 83+8;
@@ -26,8 +31,8 @@ namespace [[cheerp::genericjs]] client
 
 
 /*-- These should be in workslate-wasm.h --*/
-#define SIM_CYCLES_PER_FRAME 2000000/2   // 2 MHz clock, simulate 1/60 sec frame
-void push_kbd_fifo(uint32_t f);       // from workslate_hw.c
+extern int power_is_on;               // from workslate_hw.c
+int kbd_event(uint32_t event);        // from workslate_hw.c
 void rtc_update(struct timespec *ts); // from workslate_hw.c
 
 extern unsigned char rom_u14[0x8000]; // not used
@@ -36,144 +41,13 @@ extern unsigned char rom_u16[0x8000]; // boot bank
 extern unsigned char resource_u15_bin[];
 extern unsigned char resource_u16_bin[];
 void set_system_time(uint64_t milliseconds);
+extern int virtual_time;              // from workslate_hw.c
 void workslate_hw_reset(void);
 unsigned char mread(unsigned short addr);
 
 extern FILE *mon_out;
 extern FILE *mon_in;
 
-// Font.  LSB=top.   A space before the first tab means it's been visually checked vs. workslate
-static uint8_t const lcd_font[128][6] = {
- 	{ 0x10, 0x38, 0x54, 0x10, 0x10, 0x10 },  // 00   0  ←
- 	{ 0x10, 0x10, 0x10, 0x54, 0x38, 0x10 },  // 01   1  →
- 	{ 0x00, 0x7F, 0x41, 0x55, 0x41, 0x7F },  // 02   2  ✇ (square tape)
- 	{ 0x00, 0x02, 0x55, 0x7d, 0x02, 0x00 },  // 03   3  ⚿ key
- 	{ 0x00, 0x22, 0x14, 0x08, 0x14, 0x22 },  // 04   4  ×
- 	{ 0x00, 0x08, 0x08, 0x2A, 0x08, 0x08 },  // 05   5  ÷
- 	{ 0x00, 0x54, 0x34, 0x1C, 0x16, 0x15 },  // 06   6  ≠
- 	{ 0x00, 0x20, 0x38, 0x7C, 0x38, 0x20 },  // 07   7 🔔
- 	{ 0x00, 0x7e, 0xff, 0xe7, 0xe7, 0x00 },  // 08   8 📞
- 	{ 0x3E, 0x41, 0x4F, 0x51, 0x61, 0x3E },  // 09   9  ◷
- 	{ 0x00, 0x0F, 0x08, 0xF8, 0x50, 0x10 },  // 0A  10  ␊
- 	{ 0x00, 0x08, 0x1C, 0x3E, 0x7F, 0x00 },  // 0B  11  ◀
- 	{ 0x00, 0x1F, 0x05, 0xF9, 0x28, 0x08 },  // 0C  12  ␌
- 	{ 0x00, 0x0F, 0x09, 0xF9, 0x50, 0xA0 },  // 0D  13  ␍
- 	{ 0x00, 0x00, 0xF8, 0xF8, 0x18, 0x18 },  // 0E  14  ┏
- 	{ 0x18, 0x18, 0xF8, 0xF8, 0x00, 0x00 },  // 0F  15  ┓
- 	{ 0x00, 0x00, 0x1F, 0x1F, 0x18, 0x18 },  // 10  16  ┗
- 	{ 0x18, 0x18, 0x1F, 0x1F, 0x00, 0x00 },  // 11  17  ┛
- 	{ 0x18, 0x18, 0xFF, 0xFF, 0x18, 0x18 },  // 12  18  ╋
- 	{ 0x18, 0x18, 0xF8, 0xF8, 0x18, 0x18 },  // 13  19  ┳
- 	{ 0x18, 0x18, 0x1F, 0x1F, 0x18, 0x18 },  // 14  20  ┻
- 	{ 0x00, 0x00, 0xFF, 0xFF, 0x18, 0x18 },  // 15  21  ┣
- 	{ 0x18, 0x18, 0xFF, 0xFF, 0x00, 0x00 },  // 16  22  ┫
- 	{ 0x00, 0x00, 0xFF, 0xFF, 0x00, 0x00 },  // 17  23  ┃
- 	{ 0x18, 0x18, 0x18, 0x18, 0x18, 0x18 },  // 18  24  ━
-	{ 0x14, 0x14, 0x14, 0x14, 0x14, 0x14 },  // 19  25  ═
-	{ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF },  // 1A  26  ▣
-	{ 0x00, 0x1F, 0x15, 0xF1, 0xA0, 0xA0 },  // 1B  27  ␛
- 	{ 0x00, 0x0F, 0x09, 0x19, 0xF0, 0x10 },  // 1C  28  CT
-	{ 0xFF, 0xF1, 0xF1, 0xF1, 0xF1, 0xFF },  // 1D  29  ⬓
-	{ 0xFF, 0x81, 0x81, 0xFF, 0xFF, 0xFF },  // 1E  30  ◨
-	{ 0x7F, 0x41, 0x41, 0x41, 0x41, 0x7F },  // 1F  31  ▢
- 	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // 20  32
- 	{ 0x00, 0x00, 0x00, 0x4F, 0x00, 0x00 },  // 21  33  !
- 	{ 0x00, 0x00, 0x07, 0x00, 0x07, 0x00 },  // 22  34  "
- 	{ 0x00, 0x14, 0x7F, 0x14, 0x7F, 0x14 },  // 23  35  #
- 	{ 0x00, 0x24, 0x2A, 0x7F, 0x2A, 0x12 },  // 24  36  $
- 	{ 0x00, 0x63, 0x13, 0x08, 0x64, 0x63 },  // 25  37  %
- 	{ 0x00, 0x36, 0x49, 0x55, 0x22, 0x50 },  // 26  38  &
- 	{ 0x00, 0x00, 0x05, 0x03, 0x00, 0x00 },  // 27  39  '
- 	{ 0x00, 0x00, 0x1C, 0x22, 0x41, 0x00 },  // 28  40  (
- 	{ 0x00, 0x00, 0x41, 0x22, 0x1C, 0x00 },  // 29  41  )
- 	{ 0x00, 0x14, 0x08, 0x3E, 0x08, 0x14 },  // 2A  42  *
-	{ 0x00, 0x08, 0x08, 0x3E, 0x08, 0x08 },  // 2B  43  +
-	{ 0x00, 0x00, 0x50, 0x30, 0x00, 0x00 },  // 2C  44  ,
- 	{ 0x00, 0x08, 0x08, 0x08, 0x08, 0x08 },  // 2D  45  -
-	{ 0x00, 0x00, 0x60, 0x60, 0x00, 0x00 },  // 2E  46  .
- 	{ 0x00, 0x40, 0x20, 0x10, 0x08, 0x04 },  // 2F  47  /
-	{ 0x00, 0x3E, 0x51, 0x49, 0x45, 0x3E },  // 30  48  0
- 	{ 0x00, 0x00, 0x42, 0x7F, 0x40, 0x00 },  // 31  49  1
- 	{ 0x00, 0x42, 0x61, 0x51, 0x49, 0x46 },  // 32  50  2
- 	{ 0x00, 0x21, 0x41, 0x45, 0x4B, 0x31 },  // 33  51  3
- 	{ 0x00, 0x18, 0x14, 0x12, 0x7F, 0x10 },  // 34  52  4
- 	{ 0x00, 0x27, 0x45, 0x45, 0x45, 0x39 },  // 35  53  5
- 	{ 0x00, 0x3C, 0x4A, 0x49, 0x49, 0x30 },  // 36  54  6
- 	{ 0x00, 0x01, 0x71, 0x09, 0x05, 0x03 },  // 37  55  7
- 	{ 0x00, 0x36, 0x49, 0x49, 0x49, 0x36 },  // 38  56  8
- 	{ 0x00, 0x06, 0x49, 0x49, 0x29, 0x1E },  // 39  57  9
-	{ 0x00, 0x00, 0x36, 0x36, 0x00, 0x00 },  // 3A  58  :
-	{ 0x00, 0x00, 0x56, 0x36, 0x00, 0x00 },  // 3B  59  ;
- 	{ 0x00, 0x08, 0x14, 0x22, 0x41, 0x00 },  // 3C  60  <
-	{ 0x00, 0x14, 0x14, 0x14, 0x14, 0x14 },  // 3D  61  =
- 	{ 0x00, 0x00, 0x41, 0x22, 0x14, 0x08 },  // 3E  62  >
- 	{ 0x00, 0x02, 0x01, 0x51, 0x09, 0x06 },  // 3F  63  ?
- 	{ 0x00, 0x3E, 0x41, 0x5D, 0x55, 0x1E },  // 40  64  @
-	{ 0x00, 0x7E, 0x09, 0x09, 0x09, 0x7E },  // 41  65  A
-	{ 0x00, 0x7F, 0x49, 0x49, 0x49, 0x36 },  // 42  66  B
-	{ 0x00, 0x3E, 0x41, 0x41, 0x41, 0x22 },  // 43  67  C
-	{ 0x00, 0x7F, 0x41, 0x41, 0x22, 0x1C },  // 44  68  D
-	{ 0x00, 0x7F, 0x49, 0x49, 0x49, 0x41 },  // 45  69  E
-	{ 0x00, 0x7F, 0x09, 0x09, 0x09, 0x01 },  // 46  70  F
-	{ 0x00, 0x3E, 0x41, 0x49, 0x49, 0x7A },  // 47  71  G
-	{ 0x00, 0x7F, 0x08, 0x08, 0x08, 0x7F },  // 48  72  H
-	{ 0x00, 0x00, 0x41, 0x7F, 0x41, 0x00 },  // 49  73  I
-	{ 0x00, 0x20, 0x40, 0x41, 0x3F, 0x01 },  // 4A  74  J
-	{ 0x00, 0x7F, 0x08, 0x14, 0x22, 0x41 },  // 4B  75  K
-	{ 0x00, 0x7F, 0x40, 0x40, 0x40, 0x40 },  // 4C  76  L
-	{ 0x00, 0x7F, 0x02, 0x0C, 0x02, 0x7F },  // 4D  77  M
-	{ 0x00, 0x7F, 0x04, 0x08, 0x10, 0x7F },  // 4E  78  N
-	{ 0x00, 0x3E, 0x41, 0x41, 0x41, 0x3E },  // 4F  79  O
-	{ 0x00, 0x7F, 0x09, 0x09, 0x09, 0x06 },  // 50  80  P
-	{ 0x00, 0x3E, 0x41, 0x51, 0x21, 0x5E },  // 51  81  Q
-	{ 0x00, 0x7F, 0x09, 0x19, 0x29, 0x46 },  // 52  82  R
-	{ 0x00, 0x46, 0x49, 0x49, 0x49, 0x31 },  // 53  83  S
-	{ 0x00, 0x01, 0x01, 0x7F, 0x01, 0x01 },  // 54  84  T
-	{ 0x00, 0x3F, 0x40, 0x40, 0x40, 0x3F },  // 55  85  U
-	{ 0x00, 0x1F, 0x20, 0x40, 0x20, 0x1F },  // 56  86  V
-	{ 0x00, 0x3F, 0x40, 0x38, 0x40, 0x3F },  // 57  87  W
-	{ 0x00, 0x63, 0x14, 0x08, 0x14, 0x63 },  // 58  88  X
-	{ 0x00, 0x07, 0x08, 0x70, 0x08, 0x07 },  // 59  89  Y
-	{ 0x00, 0x61, 0x51, 0x49, 0x45, 0x43 },  // 5A  90  Z
- 	{ 0x00, 0x00, 0x7F, 0x41, 0x41, 0x00 },  // 5B  91  [
- 	{ 0x00, 0x02, 0x04, 0x08, 0x10, 0x20 },  // 5C  92  '\'
- 	{ 0x00, 0x00, 0x41, 0x41, 0x7F, 0x00 },  // 5D  93  ]
- 	{ 0x00, 0x04, 0x02, 0x01, 0x02, 0x04 },  // 5E  94  ^
- 	{ 0x40, 0x40, 0x40, 0x40, 0x40, 0x40 },  // 5F  95  _
- 	{ 0x00, 0x00, 0x03, 0x05, 0x00, 0x00 },  // 60  96  `
- 	{ 0x00, 0x20, 0x54, 0x54, 0x54, 0x78 },  // 61  97  a
- 	{ 0x00, 0x7F, 0x44, 0x44, 0x44, 0x38 },  // 62  98  b
- 	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x00 },  // 63  99  c
- 	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x7F },  // 64 100  d
- 	{ 0x00, 0x38, 0x54, 0x54, 0x54, 0x18 },  // 65 101  e
- 	{ 0x00, 0x08, 0x7E, 0x09, 0x01, 0x02 },  // 66 102  f
- 	{ 0x00, 0x18, 0xA4, 0xA4, 0xA4, 0x7C },  // 67 103  g
- 	{ 0x00, 0x7F, 0x08, 0x04, 0x04, 0x78 },  // 68 104  h
- 	{ 0x00, 0x00, 0x44, 0x7D, 0x40, 0x00 },  // 69 105  i
- 	{ 0x00, 0x40, 0x80, 0x88, 0x7A, 0x00 },  // 6A 106  j
- 	{ 0x00, 0x7F, 0x10, 0x28, 0x44, 0x00 },  // 6B 107  k
- 	{ 0x00, 0x00, 0x41, 0x7F, 0x40, 0x00 },  // 6C 108  l
- 	{ 0x00, 0x7C, 0x04, 0x18, 0x04, 0x7C },  // 6D 109  m
-	{ 0x00, 0x7C, 0x08, 0x04, 0x04, 0x78 },  // 6E 110  n
-	{ 0x00, 0x38, 0x44, 0x44, 0x44, 0x38 },  // 6F 111  o
- 	{ 0x00, 0xFC, 0x24, 0x24, 0x24, 0x18 },  // 70 112  p
- 	{ 0x00, 0x18, 0x24, 0x24, 0x28, 0xFC },  // 71 113  q
- 	{ 0x00, 0x7C, 0x08, 0x04, 0x04, 0x08 },  // 72 114  r
- 	{ 0x00, 0x48, 0x54, 0x54, 0x54, 0x24 },  // 73 115  s
- 	{ 0x00, 0x04, 0x3F, 0x44, 0x40, 0x20 },  // 74 116  t
- 	{ 0x00, 0x3C, 0x40, 0x40, 0x20, 0x7C },  // 75 117  u
- 	{ 0x00, 0x1C, 0x20, 0x40, 0x20, 0x1C },  // 76 118  v
- 	{ 0x00, 0x3C, 0x40, 0x30, 0x40, 0x3C },  // 77 119  w
- 	{ 0x00, 0x44, 0x28, 0x10, 0x28, 0x44 },  // 78 120  x
- 	{ 0x00, 0x1C, 0xA0, 0xA0, 0xA0, 0x7C },  // 79 121  y
- 	{ 0x00, 0x44, 0x64, 0x54, 0x4C, 0x44 },  // 7A 122  z
- 	{ 0x00, 0x00, 0x08, 0x36, 0x41, 0x00 },  // 7B 123  {
- 	{ 0x00, 0x00, 0x00, 0x77, 0x00, 0x00 },  // 7C 124  |
- 	{ 0x00, 0x00, 0x41, 0x36, 0x08, 0x00 },  // 7D 125  }
- 	{ 0x00, 0x04, 0x02, 0x04, 0x08, 0x04 },  // 7E 126  ~
- 	{ 0x00, 0x7F, 0x7F, 0x7F, 0x7F, 0x7F }   // 7F 127 typed with Special-L
-};
-
 typedef struct {
     int x;
     int y;
@@ -276,11 +150,31 @@ keylookup_t keylookup[] = {
 
 
 // Global because I had trouble putting it in the class below (which is translated to javascript)
-char screen_mem[lcd_native_cols][lcd_native_rows];  // used to blink cursor...
+//
+// Once per animation frame, lcd_refresh() passes the frame to lcd_show(), which
+// copies the changed cells into screen_mem and marks them dirty; then
+// redraw_screen() draws just the dirty cells and the cursor.
+char screen_mem[lcd_native_cols][lcd_native_rows];
+char screen_dirty[lcd_native_cols][lcd_native_rows];  // changed since the last frame
 int cursor_x = 0;
 int cursor_y = 0;
 int cursor_show = 0;
 int cursor_blink_state = 0;
+int cursor_drawn = 0;        // where the canvas has a cursor, if anywhere
+int cursor_drawn_x = 0;
+int cursor_drawn_y = 0;
+
+// The glyph atlas is built here on the wasm side, in one call, and the canvas
+// gets a view of it: no call across to lcd_font.c for each of its pixels.
+// Free it with free() once the canvas has it.
+uint8_t* atlas_rgba(void)
+{
+    uint8_t* rgba = (uint8_t*) malloc(LCD_ATLAS_WIDTH * LCD_ATLAS_HEIGHT * 4);
+    if (rgba) {
+        lcd_atlas_build(rgba);
+    }
+    return rgba;
+}
 
 // All the graphics code should stay on the JS side. It is possible to tag whole classes with the [[cheerp::genericjs]] tag.
 // All members and methods of this class will be compiled to standard JavaScript.
@@ -289,6 +183,7 @@ class [[cheerp::genericjs]] Graphics
 private:
     // When compiling to standard JavaScript it is possible to use DOM objects like any other C++ object.
     static client::HTMLCanvasElement* canvas;
+    static client::HTMLCanvasElement* atlas;     // every glyph, drawn once (see lcd_font.c)
     static client::CanvasRenderingContext2D* canvasCtx;
     static int canvas_width;
     static int canvas_height;
@@ -334,6 +229,19 @@ public:
         canvasCtx->set_fillStyle("green");
         canvasCtx->fillRect(lcd_base_x-6, lcd_base_y-8, lcd_base_width+12, lcd_base_height+16);
 
+        // Render all the glyphs and their inverses once.  drawChar() copies from here.
+        atlas = (client::HTMLCanvasElement*)client::document.createElement("canvas");
+        atlas->set_width(LCD_ATLAS_WIDTH);
+        atlas->set_height(LCD_ATLAS_HEIGHT);
+        client::CanvasRenderingContext2D* atlasCtx = (client::CanvasRenderingContext2D*)atlas->getContext("2d");
+        uint8_t* rgba = atlas_rgba();
+        if (rgba) {
+            client::Uint8Array* bytes = cheerp::MakeTypedArray(rgba, LCD_ATLAS_WIDTH * LCD_ATLAS_HEIGHT * 4);
+            client::Uint8ClampedArray* pixels = new client::Uint8ClampedArray(bytes->get_buffer(), bytes->get_byteOffset(), bytes->get_length());
+            atlasCtx->putImageData(new client::ImageData(pixels, LCD_ATLAS_WIDTH, LCD_ATLAS_HEIGHT), 0, 0);   // copies it
+            free(rgba);
+        }
+
         // clear screen memory
         for (int x = 0; x < lcd_native_cols; x++) {
             for (int y = 0; y < lcd_native_rows; y++) {
@@ -386,12 +294,9 @@ public:
     }
 
 
-    // Draw at screen coordinates using a bitmap font
+    // Draw at screen coordinates using a bitmap font: one copy from the glyph atlas
     static void drawChar(int x, int y, const char data)
     {
-        unsigned char c = data & 0x7f;
-        bool inverse = data & 0x80;      // inverse mode
-
         // Set a transform so we can move to pixel coordinates
         // void setTransform(double m11, double m12, double m21, double m22, double dx, double dy);
         // If a point originally had coordinates (x,y), then after the transformation
@@ -401,51 +306,44 @@ public:
         canvasCtx->setTransform( scalex, 0, 0, scaley,
                                  lcd_base_x, lcd_base_y);
 
-        // erase the whole character first - helps fix some antialiasing problems in the browser
-        canvasCtx->set_fillStyle(inverse ? "black" : "green");
-        double shrink = inverse ?  0.1 : 0; // draw black bar slightly smaller
-        canvasCtx->fillRect(x * lcd_native_char_width,
-                            y * lcd_native_char_height + shrink, 
-                            lcd_native_char_width, lcd_native_char_height - 2*shrink);
-
-        for (int cx = 0; cx < lcd_native_char_width; cx++) {
-            uint8_t d = lcd_font[(uint8_t) c][cx] ^ (inverse ? 0xFF : 0);
-            // bitmap of a single vertical column.  LSB is at top.
-
-            for (int cy = 0; cy < lcd_native_char_height; cy++) {
-                // draw a pixel
-                canvasCtx->set_fillStyle(d & 0x01 ? "black" : "green");
-                d = d >> 1;  // advance to next pixel
-                canvasCtx->fillRect(x * lcd_native_char_width  + cx,
-                                    y * lcd_native_char_height + cy, 
-                                    0.9, 0.9);  // should be 0.9
-            }
-        }
+        // bit 7 (inverse) picks the inverse half of the atlas
+        canvasCtx->drawImage(atlas, LCD_ATLAS_X(data), LCD_ATLAS_Y(data),
+                             LCD_ATLAS_GLYPH_WIDTH, LCD_ATLAS_GLYPH_HEIGHT,
+                             x * lcd_native_char_width, y * lcd_native_char_height,
+                             lcd_native_char_width, lcd_native_char_height);
 
         // back to a 1:1 transform (kindof)
         // canvasCtx->setTransform(1,0,0,1,lcd_base_x, lcd_base_y);
     }
 
-    static void draw_cursor_always(void)   // can be used to erase cursor
+    // Draw the cells that changed this frame, and the cursor if it moved or blinked
+    static void redraw_screen(void)
     {
-        if (cursor_show && cursor_blink_state) {
-            drawChar(cursor_x, cursor_y, (char) 0x80 + ' ');  // inverse space
-        } else {
-            drawChar(cursor_x, cursor_y, screen_mem[cursor_x][cursor_y]);
-        }
-    }
+        int want = cursor_show && cursor_blink_state && cursor_y < lcd_native_rows;
+        int moved = cursor_x != cursor_drawn_x || cursor_y != cursor_drawn_y;
 
-    static void blink_cursor_if_needed(uint64_t milliseconds)
-    {
-        // blink isn't syncrhonized to RTC clock (just like on actual hardware)
-        static uint64_t prev_milliseconds = 0;
-        if (milliseconds-prev_milliseconds > 500) {
-            prev_milliseconds = milliseconds;
-            cursor_blink_state = !cursor_blink_state;
-            if (cursor_show) {          // only draw if it's shown
-                draw_cursor_always();   // update on screen
+        if (cursor_drawn && (!want || moved)) {
+            screen_dirty[cursor_drawn_x][cursor_drawn_y] = 1;   // erase the old one
+        }
+        if (want && (!cursor_drawn || moved)) {
+            screen_dirty[cursor_x][cursor_y] = 1;
+        }
+        for (int x = 0; x < lcd_native_cols; x++) {
+            for (int y = 0; y < lcd_native_rows; y++) {
+                if (!screen_dirty[x][y]) {
+                    continue;
+                }
+                screen_dirty[x][y] = 0;
+                if (want && x == cursor_x && y == cursor_y) {
+                    drawChar(x, y, (char) 0x80 + ' ');  // inverse space
+                } else {
+                    drawChar(x, y, screen_mem[x][y]);
+                }
             }
         }
+        cursor_drawn = want;
+        cursor_drawn_x = cursor_x;
+        cursor_drawn_y = cursor_y;
     }
 
 
@@ -453,6 +351,9 @@ public:
 
     static void advance_rtc_if_needed(uint64_t milliseconds)
     {
+        if (virtual_time) {
+            return;  // RTC follows the cycle count instead (see workslate_hw.c)
+        }
         static uint64_t prev_seconds = 0;
         uint64_t seconds = milliseconds / 1000;
         if(prev_seconds != seconds) {
@@ -479,11 +380,18 @@ public:
     uint64_t milliseconds = client::Date().getTime();  // milliseconds since 1970
 //    printf("sec=%lld\n", milliseconds);  
 
-        blink_cursor_if_needed(milliseconds);
         advance_rtc_if_needed(milliseconds);
 
         set_system_time(milliseconds);
-        sim(SIM_CYCLES_PER_FRAME);        // TODO: tune number of cycles dynamically
+        // simulate as much time as has passed, as far as the host can keep up
+        cycles_slept_this_tick = 0;
+        sim(frame_sched_begin(milliseconds, !power_is_on ? FRAME_OFF : cpu_asleep() ? FRAME_ASLEEP : FRAME_AWAKE));
+        frame_sched_end(client::Date().getTime(), cycles_simulated_this_tick, cycles_slept_this_tick);
+        lcd_refresh();
+        redraw_screen();
+        if (lcd_watch_on) {
+            lcd_watch_frame(cycle_count);
+        }
         client::requestAnimationFrame(cheerp::Callback(sim_frame));
     }
 
@@ -512,18 +420,18 @@ public:
             case 0x76:f = 0x0120; break;  // F7 -->    Worksheet key
             case 0x14:                    // Caps lock key is special
                       e->preventDefault();  // eat character so browser doesn't scroll window
-                      push_kbd_fifo(0x20000);  // bit 17 is the special key
-                      push_kbd_fifo(0x30000);  // add in the shift key (bit 16)
-                      push_kbd_fifo(0);
+                      kbd_event(0x20000);  // bit 17 is the special key
+                      kbd_event(0x30000);  // add in the shift key (bit 16)
+                      kbd_event(0x80000000);  // bit 31 releases (all keys)
                       break;
             default: //printf("[UNKNOWN DOWN CODE KEY %02x]\n", kc);
                 break;
         }
-        if (f) {  // stuff in fifo
-            push_kbd_fifo(f);
+        if (f) {  // queue the key
+            kbd_event(f);
             e->preventDefault();  // eat character so browser doesn't scroll window
-            // stuff no-keys-pressed in fifo
-            push_kbd_fifo(0);
+            // then let go of it
+            kbd_event(0x80000000);  // bit 31 releases (all keys)
         }
     }
 
@@ -542,9 +450,9 @@ public:
         switch(kc) {
             case 0x14:                    // Caps lock key is special
                       e->preventDefault();  // eat character so browser doesn't scroll window
-                      push_kbd_fifo(0x20000);  // bit 17 is the special key
-                      push_kbd_fifo(0x30000);  // add in the shift key (bit 16)
-                      push_kbd_fifo(0);
+                      kbd_event(0x20000);  // bit 17 is the special key
+                      kbd_event(0x30000);  // add in the shift key (bit 16)
+                      kbd_event(0x80000000);  // bit 31 releases (all keys)
                       break;
             default: // printf("[UNKNOWN UP KEY CODE %02x]\n", kc);
                 break;
@@ -665,21 +573,21 @@ public:
             e->preventDefault();  // eat character so browser doesn't scroll window
             if (shift_key) {
                 // jam in just the shift key being pressed
-                push_kbd_fifo(0x10000);
+                kbd_event(0x10000);
                 // then jam in the combo next
                 f = f | 0x10000;
             }
             if (special_key) {
                 // jam in just the special key being pressed
                 // TODO: this should probably include 0x10000 if shift is pressed
-                push_kbd_fifo(0x20000);  // bit 17 is the special key
+                kbd_event(0x20000);  // bit 17 is the special key
                 // then jam in the combo next
                 f = f | 0x20000;
             }
-            // push the actual key into fifo
-            push_kbd_fifo(f);
-            // push no-keys-pressed in fifo
-            push_kbd_fifo(0);
+            // press the actual key
+            kbd_event(f);
+            // then let go of everything
+            kbd_event(0x80000000);  // bit 31 releases (all keys)
         }
     }
 
@@ -722,17 +630,17 @@ public:
             if (e->get_shiftKey()) {
                 // jam in just the shift key being pressed
                 modifier_keys = 0x10000;
-                push_kbd_fifo(modifier_keys);
+                kbd_event(modifier_keys);
             }
             if (e->get_altKey()) { // also get_metaKey get_ctrlKey
                 modifier_keys |= 0x20000;
-                push_kbd_fifo(modifier_keys);
+                kbd_event(modifier_keys);
             }
 
-            // push the actual key into fifo
-            push_kbd_fifo(f | modifier_keys);
-            // push no-keys-pressed in fifo
-            push_kbd_fifo(0);
+            // press the actual key
+            kbd_event(f | modifier_keys);
+            // then let go of everything
+            kbd_event(0x80000000);  // bit 31 releases (all keys)
         }
     }
 
@@ -748,51 +656,21 @@ public:
 
 
 
-// Low level cursor routines called from workslate_hw.c
-void move_cursor(uint16_t p)
-{
-    int y = p / lcd_native_cols;
-    int x = p % lcd_native_cols;
-    int saved_cursor_show = cursor_show;
-
-    if(saved_cursor_show) {
-        cursor_show = 0;
-        Graphics::draw_cursor_always();// erase character at old position
-    }
-
-    cursor_x = x;
-    cursor_y = y;
-
-    if(saved_cursor_show) {
-        cursor_show = saved_cursor_show;
-        Graphics::draw_cursor_always();  // draw cursor at new position
-    }
-}
-
-void show_cursor(int show)
-{
-    cursor_show = show ? 1 : 0;
-
-    Graphics::draw_cursor_always();  // update screen
-}
-
-// Low level character drawing routine called from workslate_hw.c
-void write_char_at_position(unsigned char data, uint16_t p)
+// The frame from workslate_hw.c.  This only records it; redraw_screen() draws it.
+void lcd_show(const struct lcd_frame_info *f)
 {
-    int y = p / lcd_native_cols;
-    int x = p % lcd_native_cols;
-
-    screen_mem[x][y] = data;
-    Graphics::drawChar(x, y, data);
-
-    // advance cursor
-    if(++x >= lcd_native_cols) {
-        x = 0;
-        if(++y >= lcd_native_rows) {
-            y = 0;
+    for (int p = 0; f->changes && p < LCD_CELLS; p++) {
+        int x = p % lcd_native_cols;
+        int y = p / lcd_native_cols;
+        if (f->dirty[p] && screen_mem[x][y] != (char) f->cells[p]) {
+            screen_mem[x][y] = f->cells[p];
+            screen_dirty[x][y] = 1;
         }
     }
-    move_cursor(x + y*lcd_native_cols);
+    cursor_x = f->cursor % lcd_native_cols;
+    cursor_y = f->cursor / lcd_native_cols;
+    cursor_show = f->cursor_on;
+    cursor_blink_state = f->blink;   // blinks on emulated time, like the hardware
 }
 
 
@@ -805,6 +683,7 @@ void webMain()
     //printf("DEBUG - reached %s at " __FILE__ ":%d\n", __FUNCTION__, __LINE__);
 
     Graphics::initializeCanvas();
+    frame_sched_init(E_CLOCK_FREQUENCY);
 
     mon_out = stdout;
     mon_in = stdin;
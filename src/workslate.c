@@ -35,6 +35,13 @@
 #include "workslate.h"
 #include "exorterm.h"
 #include "utils.h"    /* JMR20201103 */
+#include "pacing.h"
+#include "tape.h"
+#include "serial_bridge.h"
+#include "spooler.h"
+#include "kbd_reader.h"
+#include "snapshot.h"
+#include "lcd_watch.h"
 
 /* Options */
 
@@ -93,11 +100,62 @@ void ctrl_c()
 }
 
 #ifndef WASM  // this isn't used for web version
+/////////////////////////////
+// --lcd-events: tell a driving script what the screen is doing
+//
+//   changed <cycle> rows 0,3,4
+//   stable <cycle> since <cycle>
+//   |Type your first name, then press Do It        |    (16 rows)
+//
+// Characters the terminal can't show are printed as '.'.
+
+static void lcd_event(const struct lcd_change *c, void *arg)
+{
+    FILE *f = arg;
+    const char *sep = " ";
+
+    if (c->kind == LCD_CHANGED) {
+        fprintf(f, "changed %llu rows", (unsigned long long) c->cycle);
+        for (int row = 0; row < LCD_WATCH_ROWS; row++) {
+            if (c->rows & (1 << row)) {
+                fprintf(f, "%s%d", sep, row);
+                sep = ",";
+            }
+        }
+        fprintf(f, "\n");
+    } else {
+        fprintf(f, "stable %llu since %llu\n", (unsigned long long) c->cycle,
+                (unsigned long long) c->last_change);
+        for (int row = 0; row < LCD_WATCH_ROWS; row++) {
+            fputc('|', f);
+            for (int col = 0; col < LCD_WATCH_COLS; col++) {
+                uint8_t ch = c->screen[row * LCD_WATCH_COLS + col] & 0x7F;
+                fputc(ch >= 0x20 && ch < 0x7F ? ch : '.', f);
+            }
+            fprintf(f, "|\n");
+        }
+    }
+    fflush(f);
+}
+
 int main(int argc, char *argv[])
 {
     mon_out = stdout;
     mon_in = stdin;
     const char *facts_name = "resource/workslate_facts";
+    const char *speed = NULL;
+    uint32_t cycles = 0;
+    const char *tape_name = NULL;
+    const char *tape_hl_name = NULL;
+    const char *serial_name = NULL;
+    const char *print_dir = NULL;
+    const char *snapshot_path = NULL;
+    uint32_t snapshot_every = 0;
+    const char *record_name = NULL;
+    const char *events_name = NULL;
+    uint32_t stable_ms = 500;
+    const char *socket_path = NULL;
+    uint32_t socket_fps = 0;
 
     for (int x = 1; x < argc; ++x) {
         if (argv[x][0] == '-') {
@@ -115,6 +173,45 @@ int main(int argc, char *argv[])
                 skip = atoi(argv[x]);
             } else if (!strcmp(argv[x], "--romdir") && x + 1 != argc) {
                 rom_dir = argv[++x];
+            } else if (!strcmp(argv[x], "--speed") && x + 1 != argc
+                       && !pacing_set_speed(argv[x + 1])) {
+                speed = argv[++x];
+            } else if (!strcmp(argv[x], "--virtual-time")) {
+                virtual_time = 1;
+            } else if (!strcmp(argv[x], "--epoch") && x + 1 != argc) {
+                rtc_epoch = atoll(argv[++x]);
+            } else if (!strcmp(argv[x], "--cycles") && x + 1 != argc) {
+                cycles = strtoul(argv[++x], NULL, 0);
+            } else if (!strcmp(argv[x], "--tape") && x + 1 != argc) {
+                tape_name = argv[++x];
+            } else if (!strcmp(argv[x], "--tape-hl") && x + 1 != argc) {
+                tape_hl_name = argv[++x];
+            } else if (!strcmp(argv[x], "--tape-fast")) {
+                tape_fast = 1;
+            } else if (!strcmp(argv[x], "--serial") && x + 1 != argc) {
+                serial_name = argv[++x];
+            } else if (!strcmp(argv[x], "--fast-keys")) {
+                kbd_fast = 1;
+            } else if (!strcmp(argv[x], "--print") && x + 1 != argc) {
+                print_dir = argv[++x];
+            } else if (!strcmp(argv[x], "--serial-fast")) {
+                serial_fast = 1;
+            } else if (!strcmp(argv[x], "--snapshots") && x + 1 != argc) {
+                snapshot_path = argv[++x];
+            } else if (!strcmp(argv[x], "--snapshot-every") && x + 1 != argc) {
+                snapshot_every = strtoul(argv[++x], NULL, 0);
+            } else if (!strcmp(argv[x], "--headless")) {
+                lcd_headless = 1;
+            } else if (!strcmp(argv[x], "--record-lcd") && x + 1 != argc) {
+                record_name = argv[++x];
+            } else if (!strcmp(argv[x], "--lcd-events") && x + 1 != argc) {
+                events_name = argv[++x];
+            } else if (!strcmp(argv[x], "--lcd-stable") && x + 1 != argc) {
+                stable_ms = strtoul(argv[++x], NULL, 0);
+            } else if (!strcmp(argv[x], "--lcd-socket") && x + 1 != argc) {
+                socket_path = argv[++x];
+            } else if (!strcmp(argv[x], "--lcd-fps") && x + 1 != argc) {
+                socket_fps = strtoul(argv[++x], NULL, 0);
             } else {
                 printf("Workslate simulator\n");
                 printf("\n");
@@ -127,6 +224,30 @@ int main(int argc, char *argv[])
                 printf("  --facts file  Process facts files for commented disassembly\n");
                 printf("  --lower       Allow lowercase\n");
                 printf("  --mon         Start at monitor prompt\n");
+                printf("  --speed n     Run at n times real time (1x, 4x, 0.5x) or 'max' for unthrottled\n");
+                printf("                'auto' runs at 1x while idle, unthrottled while the firmware is busy\n");
+                printf("  --virtual-time  Derive RTC and logs from the cycle count (reproducible runs).\n");
+                printf("                Runs at max speed unless --speed is given (switched off, at\n");
+                printf("                host speed unless --cycles is given too)\n");
+                printf("  --epoch n     Start the RTC at n seconds since 1970 (UTC)\n");
+                printf("  --cycles n    Exit after simulating n cycles\n");
+                printf("  --tape file   Put tape image in the microcassette drive (created if missing)\n");
+                printf("  --tape-fast   Skip tape mechanism delays, and run unthrottled while the tape moves\n");
+                printf("  --tape-hl file  High-level tape: Save/Get bytes go straight to file, not over the tape\n");
+                printf("  --serial pty  Connect the I/O Box serial port to a new pseudo-terminal\n");
+                printf("  --serial unix:path  ... or to a Unix socket\n");
+                printf("  --serial-fast  Ignore the baud rate: receive as fast as the firmware reads\n");
+                printf("  --fast-keys   Feed typed keys as fast as the firmware takes them (for pasting/scripts)\n");
+                printf("  --print dir   Spool serial output to dir/print001.txt, one file per print job\n");
+                printf("  --snapshots file.png  Save screen snapshots as file00001.png, ... (or .ppm)\n");
+                printf("                Taken on SIGUSR1, and with --snapshot-every\n");
+                printf("  --snapshot-every n  Also take a snapshot every n frames (30 frames/sec)\n");
+                printf("  --headless    Don't draw the screen on the terminal\n");
+                printf("  --record-lcd file  Record every screen change to file (play with build/gcc/lcdplay)\n");
+                printf("  --lcd-events file  Write screen changes to file (or a fifo), and the whole screen\n");
+                printf("                once it has been stable for --lcd-stable ms (emulated, default 500)\n");
+                printf("  --lcd-socket path  Stream the screen to viewers on a Unix socket (lcdrec.h format)\n");
+                printf("  --lcd-fps n   At most n updates per second on the socket (default 10)\n");
                 printf("\n");
                 exit(-1);
             }
@@ -146,6 +267,10 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (virtual_time && !speed) {
+        pacing_set_speed("max");
+    }
+
     /* Default memory image name */
     if (!rom_dir) {
         rom_dir = "resource";
@@ -159,20 +284,58 @@ int main(int argc, char *argv[])
         stop = 1;
     }
 
+    if (tape_name && tape_insert(tape_name)) {
+        exit(-1);
+    }
+    if (tape_hl_name && (tape_hl_init() || tape_hl_insert(tape_hl_name))) {
+        exit(-1);
+    }
+    if (kbd_init() && kbd_fast) {
+        exit(-1);
+    }
+    if (serial_name && serial_bridge_open(serial_name)) {
+        exit(-1);
+    }
+    if (print_dir && spooler_open(print_dir)) {
+        exit(-1);
+    }
+    if (snapshot_path && snapshot_open(snapshot_path, snapshot_every)) {
+        exit(-1);
+    }
+    if (record_name && lcd_record_open(record_name)) {
+        exit(-1);
+    }
+    if (socket_path && lcd_stream_start(socket_path, socket_fps)) {
+        exit(-1);
+    }
+
     /* Read starting address from reset vector */
     workslate_hw_reset(); // set bank to start in
     pc = ((mread(0xFFFE) << 8) + mread(0xFFFF));
 
+    if (events_name) {
+        FILE *f = fopen(events_name, "w");
+        if (!f) {
+            perror(events_name);
+            exit(-1);
+        }
+        lcd_watch_add(lcd_event, f, stable_ms);
+    }
+
     /* system("stty cbreak -echo -icrnl"); */
     save_termios();
     sim_termios();
 
     signal(SIGINT, ctrl_c);
+    if (kbd_reader_start()) {
+        exit(-1);
+    }
     printf("\nHit Ctrl-C for simulator command line.  Starting simulation...\n");
 
     izexorterm();
 
-    sim(0);  // simulate with no cycle limit
+    sim(cycles);  // 0 = simulate with no cycle limit
+    lcd_refresh();  // last changes to the screen
     // echo test of terminal emulator
     // while (!stop) term_out(term_in());
 
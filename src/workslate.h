@@ -4,7 +4,63 @@ extern FILE *mon_in;
 
 //extern unsigned char mem[65536];
 extern unsigned char mread(unsigned short addr);
+extern unsigned char mpeek(unsigned char bank, unsigned short addr);   // no side effects
 extern void mwrite(unsigned short addr, unsigned char data);
 extern void workslate_hw_reset(void);
 extern int lower;
 extern int polling;
+
+// Clock frequency
+// This is 1/4 of the external crystal.  Up to 2 MHz with "B" version of CPU.
+// The board has a 4.9152 MHz crystal (also used on the serial port adapter).
+// This used to be set to 20 MHz because the emulator felt sluggish; use --speed
+// to run faster than the real hardware instead.
+#define E_CLOCK_FREQUENCY  (4915200/4)
+
+// virtual time (workslate_hw.c)
+extern uint64_t cycle_count;
+extern int virtual_time;
+extern int64_t rtc_epoch;
+
+// CPU sleep (workslate_hw.c)
+extern uint32_t cycles_slept_this_tick;   // cycles skipped in SLP, for the caller of sim() to reset
+int cpu_asleep(void);                     // the CPU is in SLP
+
+// keyboard (workslate_hw.c).  Keys are 00 0s pp rr words (pp=probe column,
+// rr=response row) plus these bits
+#define KBD_SHIFT     0x10000
+#define KBD_SPECIAL   0x20000
+#define KBD_POWER     0x40000
+#define KBD_RELEASE   0x80000000    // event: the keys come up (no keys = all keys)
+int kbd_event(uint32_t event);      // -1 if the queue is full
+void kbd_clear(void);
+extern int kbd_fast;
+int kbd_init(void);               // after loading facts.  -1 if they don't cover the keyboard
+
+// LCD (workslate_hw.c)
+#define LCD_COLS          46
+#define LCD_ROWS          16
+#define LCD_CELLS         (LCD_COLS * LCD_ROWS)
+
+// One display refresh, for the frontend
+struct lcd_frame_info {
+    const uint8_t *cells;         // LCD_CELLS chars, bit 7 = inverse
+    const uint8_t *dirty;         // 1 = changed since the last frame
+    int changes;                  // how many cells are dirty
+    uint16_t cursor;              // LCD address the cursor is on (may be off screen)
+    uint8_t mode;                 // last mode write
+    int cursor_on;                // mode says show the cursor
+    int blink;                    // blink phase: 1 = a blinking cursor is lit
+    uint64_t cycle;
+};
+void lcd_refresh(void);           // calls lcd_show() with what changed since the last frame
+void lcd_show(const struct lcd_frame_info *f);   // each frontend has one
+extern int lcd_headless;          // terminal: don't draw the screen (--headless)
+int lcd_record_open(const char *filename);   // terminal: --record-lcd, -1 on error
+int lcd_stream_start(const char *path, uint32_t max_fps);   // terminal: --lcd-socket, -1 on error
+
+// serial port (workslate_hw.c)
+extern int serial_fast;
+
+// high-level tape (workslate_hw.c)
+int tape_hl_init(void);
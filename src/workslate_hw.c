@@ -43,14 +43,17 @@
 #include "workslate.h"
 #include "exorterm.h"
 #include "utils.h"    /* JMR20201103 */
-
-/* Clock frequency */
-// This is 1/4 of the external crystal.  Up to 2 MHz with "B" version of CPU.
-// The board has a 4.9152 MHz crystal (also used on the serial port adapter), but this
-// doesn't work to well - probably because we overestimate the cycles (e.g. INX takes 6, 
-// DECB takes 5, BHI takes 4), so 2 MHz is probably closer to accurate.
-#define E_CLOCK_FREQUENCY  20000000  // TODO this is 20MHz; should be 2 MHz
-//#define E_CLOCK_FREQUENCY  (4915200/4)
+#include "pacing.h"
+#include "tape.h"
+#include "serial_bridge.h"
+#include "spooler.h"
+#include "kbd_reader.h"
+#include "reglog.h"
+#include "snapshot.h"
+#include "lcdrec.h"
+#include "lcd_font.h"
+#include "lcd_watch.h"
+#include "lcd_stream.h"
 
 /* Memory */
 #define RAMSIZE 0x4000     // code looks like it wouild support 32kB! but not tested
@@ -81,8 +84,8 @@ extern int trace_idx; // for debugging
 #define ADDR_CLR           0x0A   //
 #define ADDR_OCHR          0x0B   // Output compare register
 #define ADDR_OCLR          0x0C
-//#define ADDR_ICHR          0x0D
-//#define ADDR_ICLR          0x0E
+#define ADDR_ICHR          0x0D   // Input capture register (tape playback)
+#define ADDR_ICLR          0x0E
 #define ADDR_PORT3_CSR     0x0F
 
 #define ADDR_RMCR          0x10   // SCI Rate and Mode Control Register  (only lower 4 bits)
@@ -126,30 +129,62 @@ static unsigned char rtc_mem[ADDR_RTC_END - ADDR_RTC_START + 1];
 
 /* fwd decl */
 void rtc_update(struct timespec *ts);
+int test_serial_rx_fifo_empty(void);
 int test_serial_rx_fifo_has_character(void);
 uint8_t pull_serial_rx_fifo(void);
-void clear_kbd_fifo(void);
+static int serial_tx_ready(void);
+#ifndef WASM
+static void poll_serial_host(void);
+#endif
 void workslate_hw_reset(void);
 
 /////////////////////////////
-// General logger utility
+// Virtual time
 //
+// Normally the RTC follows the host clock.  In virtual time mode everything is
+// derived from the emulated cycle count instead: the RTC ticks once every
+// E_CLOCK_FREQUENCY cycles, starting from rtc_epoch, and logs are stamped with
+// cycles.  Given the same inputs, runs are then reproducible bit-for-bit.
 
-#if !defined(WASM)
-void logit(char * s, uint8_t data)
-{   static FILE *f = NULL;
-    if (f==NULL) f=fopen("register_access_log.txt", "w");
+uint64_t cycle_count = 0;          // total E cycles since the emulator started
+int virtual_time = 0;
+int64_t rtc_epoch = -1;            // seconds since 1970 to start the RTC at.  -1=let firmware set default
+static uint32_t virtual_rtc_cycles = 0;
+
+/////////////////////////////
+// Register access logger
+//
+// Each call adds a binary record (cycle, PC, register, value) to the log, see
+// reglog.h.  The file is only written by reglog's background thread, so
+// logging can stay on without changing the timing.  Decode the log with
+// build/gcc/reglog_decode.
 
-    //fprintf(f, "%04x %s\n", Timer_Counter, s);
+#if !defined(WASM)
+void logit(uint8_t kind, uint8_t reg, uint8_t data)
+{
+    static int tried = 0;
+    struct reglog_record r;
 
-// TODO: use internal cyclecount instead of system time
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    fprintf(f, "%3ld.%06ld - PC=%d.%04x data=%02x %s\n", ts.tv_sec % 1000, ts.tv_nsec / 1000,
-            get_bank(), pc, data, s);
+    if (!reglog_on) {
+        if (tried) {
+            return;    // couldn't open the log
+        }
+        tried = 1;
+        if (reglog_open("register_access_log.bin", E_CLOCK_FREQUENCY)) {
+            return;
+        }
+    }
+    memset(&r, 0, sizeof(r));
+    r.cycle = cycle_count;
+    r.pc = pc;
+    r.bank = get_bank();
+    r.reg = reg;
+    r.value = data;
+    r.kind = kind;
+    reglog_write(&r);
 }
 #else
-#define logit(str, data) ;
+#define logit(kind, reg, data) ;
 #endif
 
 /////////////////////////////
@@ -163,6 +198,8 @@ void logit(char * s, uint8_t data)
 
 unsigned short Timer_Counter = 0x0000;
 unsigned short Timer_OutputCompare = 0xFFFF;
+static unsigned int rtc_counter = 0;   // RTC periodic interrupt divider
+uint32_t serial_cycles_until_next_char = 0;
 
 // Setter for local time variable - number of milliseconds since 1970 (WASM only)
 #ifdef WASM
@@ -177,45 +214,63 @@ void set_system_time(uint64_t milliseconds)
 // (we don't emulate the ADDR_OCHR one-cycle inhibit feature so we could misstrigger,
 // but that doesn't look possible in the workslate ISR)
 
-// 5 msec is 30% CPU and more responsive.  100 msec is 20% CPU and less responsive.
-// We could optimize SLP instruction, but we don'.t
-#define SLEEP_STEP_TIME 0.005 
+// Tape position ticks come in on NMI, and the playback signal on input capture (P20)
+static void tape_events(int ev)
+{
+    if (ev & TAPE_EV_TICK) {
+        abrt = 1;
+    }
+    if ((ev & TAPE_EV_EDGE) && tape_in_level() == ((ram[ADDR_TCSR] & 0x02) >> 1)) {  // IEDG selects the edge
+        ram[ADDR_ICHR] = Timer_Counter >> 8;
+        ram[ADDR_ICLR] = Timer_Counter & 0xFF;
+        ram[ADDR_TCSR] |= 0x80;  // set ICF flag
+        if (ram[ADDR_TCSR] & 0x10) {
+            assert_irq(ADDR_ICF_VECTOR);
+        }
+    }
+}
+
+#ifndef WASM
+#define LCD_FRAME_CYCLES  (E_CLOCK_FREQUENCY / 30)   // 30 frames/sec
+
+static uint64_t lcd_frame_at = 0;         // cycle_count at the last frame
+static void lcd_frame_if_due(void);
+#endif
+
+// Real-time pacing (terminal version) is done by pacing.c, every pacing_countdown cycles.
+// The terminal's LCD is also redrawn from there.
 void advance_cycle(void)
 {
     cycles_simulated_this_tick++;  // Count cycles so sim() can simulate a fixed time (used in WASM)
+    cycle_count++;
 
 #ifndef WASM   // WASM regulates time differently
-    // Slow down to real time
-    static uint32_t cyclecount = -1;
-    static struct timespec ts;
-    if(cyclecount++ >= SLEEP_STEP_TIME * E_CLOCK_FREQUENCY) {  // every 5 milliseconds of simulated time
-        if(cyclecount == 0) {  // if first time
-            clock_gettime(CLOCK_MONOTONIC, &ts);
+    if (--pacing_countdown == 0) {
+        if (pacing_checkpoint() && !virtual_time) {
+            rtc_update(NULL);   // a host second has passed
         }
-        cyclecount = 0;
-        ts.tv_nsec += SLEEP_STEP_TIME * 1000000000;
-        if(ts.tv_nsec >=  1000000000) {
-            ts.tv_nsec -= 1000000000;
-            ts.tv_sec++;
-            rtc_update(&ts);
+        if (serial_bridge_on || spooler_on) {
+            poll_serial_host();
         }
-#ifdef __MACH__
-        clock_nanosleep_abstime(&ts);
-#else
-        // linux version untested
-        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
-#endif
+    }
+    if (cycle_count - lcd_frame_at >= LCD_FRAME_CYCLES) {
+        lcd_frame_if_due();   // on the exact cycle, so the frame rate doesn't drift
     }
 #endif // WASM
     // WASM updates rtc with function advance_rtc_if_needed()
 
+    if (virtual_time && ++virtual_rtc_cycles >= E_CLOCK_FREQUENCY) {
+        virtual_rtc_cycles = 0;
+        rtc_update(NULL);       // an emulated second has passed
+    }
+
 
     //--- CPU ---
     // Timer has no pre-scaler ... just advances on every E cycle.
     Timer_Counter++;
 
     if ((Timer_Counter == 0x0000) && (ram[ADDR_TCSR] & 0x04))  {   // Overflow
-        // logit(ram[ADDR_TCSR] & 0x20 ? "Timer overflow - TOF was set" : "Timer overflow - TOF was clear", 0);
+        // logit(REGLOG_EVENT, ADDR_TCSR, ram[ADDR_TCSR]);   // timer overflow (TOF is the old value)
         ram[ADDR_TCSR] |= 0x20;  // set TOF flag
         assert_irq(ADDR_TOF_VECTOR);
         // stop = 1;
@@ -223,13 +278,21 @@ void advance_cycle(void)
     }
 
     if ((Timer_Counter == Timer_OutputCompare) && (ram[ADDR_TCSR] & 0x08))  {   // Output Compare
-        // logit(ram[ADDR_TCSR] & 0x40 ? "Timer compare - OCF was set" : "Timer compare - OCF was clear", 0);
+        // logit(REGLOG_EVENT, ADDR_TCSR, ram[ADDR_TCSR]);   // timer compare (OCF is the old value)
         ram[ADDR_TCSR] |= 0x40;  // set OCF flag
         assert_irq(ADDR_OCF_VECTOR);
+        if (ram[ADDR_PORT2_DDR] & 0x02) {   // OLVL goes out on P21 (tape record signal)
+            ram[ADDR_PORT2] = (ram[ADDR_PORT2] & ~0x02) | ((ram[ADDR_TCSR] & 0x01) << 1);
+        }
         // stop = 1;
         // printf("TIMER OUTPUT COMPARE");
     }
 
+    //--- Tape ---
+    if (tape_active) {
+        tape_events(tape_clock(1, (ram[ADDR_PORT2] >> 1) & 1));
+    }
+
     //--- Serial Port ---
     if((ram[ADDR_TRCSR] & 0x08) && test_serial_rx_fifo_has_character())
     {   // if RX enabled & have a character
@@ -241,7 +304,6 @@ void advance_cycle(void)
 
     //--- RTC ---
     // TODO:  This takes 20% of out sim time
-    static unsigned int rtc_counter = 0;
     unsigned char rate_select = rtc_mem[0x0A] & 0x0F;
     if(rate_select) {
         unsigned char prev_PF = rtc_counter & (1 << (rate_select + 7)) ? 1 : 0;
@@ -253,7 +315,7 @@ void advance_cycle(void)
             rtc_mem[0x0C] |= 0x40;
             // Check if we should trigger an interrupt
             if(rtc_mem[0x0B] & 0x40) { // PIE interrupt enable
-                // logit(rtc_mem[0x0C] & 0x80 ? "RTC PIE - PF was set" : "RTC PIE - PF was clear", 0);
+                // logit(REGLOG_EVENT, ADDR_RTC_START + 0x0C, rtc_mem[0x0C]);   // RTC PIE
                 rtc_mem[0x0C] |= 0x80;  // signal we generated an interrupt
                 assert_irq(ADDR_IRQ1_VECTOR);
             }
@@ -261,6 +323,120 @@ void advance_cycle(void)
     } // else counter is stopped, so don't do anything
 }
 
+// Number of cycles until advance_cycle() next has something to do: a timer,
+// RTC or serial event, a virtual RTC second, or an LCD frame.
+static uint32_t cycles_until_next_event(void)
+{
+    uint32_t n = 0x10000;   // just a long time
+    uint32_t k;
+
+    if (ram[ADDR_TCSR] & 0x04) {   // timer overflow (ETOI)
+        n = 0x10000 - Timer_Counter;   // a whole lap when it is at 0000
+    }
+    if (ram[ADDR_TCSR] & 0x08) {   // output compare
+        k = (uint16_t) (Timer_OutputCompare - Timer_Counter);
+        if (k && k < n) n = k;
+    }
+    unsigned char rate_select = rtc_mem[0x0A] & 0x0F;
+    if (rate_select) {             // next rising edge of PF
+        uint32_t bit = 1 << (rate_select + 7);
+        k = (bit - (rtc_counter & (2 * bit - 1))) & (2 * bit - 1);
+        if (!k) k = 2 * bit;
+        if (k < n) n = k;
+    }
+    if ((ram[ADDR_TRCSR] & 0x08) && !test_serial_rx_fifo_empty()) {
+        k = serial_cycles_until_next_char + 1;
+        if (k < n) n = k;
+    }
+    if (virtual_time) {
+        k = E_CLOCK_FREQUENCY - virtual_rtc_cycles;
+        if (k < n) n = k;
+    }
+    if (tape_active) {
+        k = tape_cycles_until_next_event();
+        if (k < n) n = k;
+    }
+#ifndef WASM
+    k = LCD_FRAME_CYCLES - (uint32_t) (cycle_count - lcd_frame_at);
+    if (k < n) n = k;
+#endif
+    return n;
+}
+
+// Advance n cycles in one go.  Nothing may happen during them, so only
+// call this with less than cycles_until_next_event().
+static void skip_cycles(uint32_t n)
+{
+    cycles_simulated_this_tick += n;
+    cycle_count += n;
+    Timer_Counter += n;
+    if (rtc_mem[0x0A] & 0x0F) {
+        rtc_counter += n;
+    }
+    if ((ram[ADDR_TRCSR] & 0x08) && !test_serial_rx_fifo_empty()) {
+        serial_cycles_until_next_char -= n;
+    }
+    if (virtual_time) {
+        virtual_rtc_cycles += n;
+    }
+    if (tape_active) {
+        tape_clock(n, (ram[ADDR_PORT2] >> 1) & 1);
+    }
+}
+
+extern int power_is_on;
+#ifndef WASM
+static void power_dormant(void);
+#endif
+static void power_up_reset(void);
+
+// Called by the simulator for every cycle spent in the SLP instruction, as
+// long as no interrupt is waiting to wake it up.
+//
+// Nothing can happen until the next timer/RTC/serial event, so skip straight
+// to the cycle before it; the SLP's next fetch then runs that cycle normally.
+// In the terminal version pacing_idle() blocks the host for that long instead
+// of waking up every few msec, or until a key or a serial byte arrives.
+uint32_t cycles_slept_this_tick = 0;
+
+void cpu_sleeping(void)
+{
+    uint32_t n = cycles_until_next_event() - 1;
+#ifndef WASM
+    int idled = 0;
+
+    if (!power_is_on) {
+        power_dormant();   // nothing to do until switched on, but time goes on
+        return;
+    }
+    pacing_note_idle();
+    if (n >= pacing_countdown) {
+        int second_rolled;
+        n = pacing_idle(n, &second_rolled);
+        if (second_rolled && !virtual_time) {
+            rtc_update(NULL);   // a host second has passed
+        }
+        idled = 1;
+    } else {
+        pacing_countdown -= n;
+    }
+#endif
+    skip_cycles(n);
+    cycles_slept_this_tick += n;
+#ifndef WASM
+    if (idled && serial_bridge_on) {
+        poll_serial_host();     // what arrived meanwhile (maybe what woke us up)
+    }
+#endif
+}
+
+// The CPU is in SLP: the simulator repeats the instruction until an
+// interrupt, so pc is still on it
+int cpu_asleep(void)
+{
+    return mpeek(get_bank(), pc) == 0x1A;
+}
+
 /////////////////////////////
 // RTC Chip - HD146818FP
 //
@@ -322,9 +498,9 @@ static void write_rtc(unsigned short addr, unsigned char data)
     }
 }
 
-static unsigned char read_rtc(unsigned short addr)
+// A register as the CPU sees it, without the side effects of reading it
+static unsigned char peek_rtc(unsigned short addr)
 {
-    unsigned char saved_reg_c;
     if(addr >= 0x0E) {        // Simple RAM
         return rtc_mem[addr];
     }
@@ -361,24 +537,31 @@ static unsigned char read_rtc(unsigned short addr)
             break;
 
         case 0x0B:  // REG B
+        case 0x0C:  // REG C
         case 0x0D:  // REG D
             return rtc_mem[addr];
-        case 0x0C:  // REG C
-            saved_reg_c = rtc_mem[addr];
-            rtc_mem[addr] = 0;  // cleared by read
-            deassert_irq(ADDR_IRQ1_VECTOR);
-            return saved_reg_c;
         case 0x0A:  // REG A
             return rtc_mem[addr] & 0x7F;  // update-in-progress bit always 0
     }
-    stop = 1; // unimplemented
     return 0;
 }
 
+static unsigned char read_rtc(unsigned short addr)
+{
+    unsigned char saved_reg_c;
+    if (addr == 0x0C) {  // REG C
+        saved_reg_c = rtc_mem[addr];
+        rtc_mem[addr] = 0;  // cleared by read
+        deassert_irq(ADDR_IRQ1_VECTOR);
+        return saved_reg_c;
+    }
+    return peek_rtc(addr);
+}
+
 void rtc_update(struct timespec *ts)  // ts isn't really used, but it could be in the future
 {
     if ((rtc_mem[0x0B] & 0x90) == 0x10) { // if not in set mode (MSB=0) and update ended interrupt enable (UIE)
-        // logit(rtc_mem[0x0C] & 0x10 ? "RTC UIE - UF was set" : "RTC UIE - UF was clear", 0);
+        // logit(REGLOG_EVENT, ADDR_RTC_START + 0x0C, rtc_mem[0x0C]);   // RTC UIE
         rtc_mem[0x0C] |= 0x10;  // signal we generated an interrupt
         assert_irq(ADDR_IRQ1_VECTOR);
     }
@@ -400,7 +583,7 @@ void rtc_update(struct timespec *ts)  // ts isn't really used, but it could be i
     if ((rtc_mem[0x0B] & 0xA0) == 0x20) { // if not in set mode (MSB=0) and alarm interrupt enable (AIE)
         // "An alarm interrupt occurs for each second that the three time bytes equal the three alarm bytes"
         // check for actual alarm
-        // logit(rtc_mem[0x0C] & 0x20 ? "RTC AIE - AF was set" : "RTC AIE - AF was clear");
+        // logit(REGLOG_EVENT, ADDR_RTC_START + 0x0C, rtc_mem[0x0C]);   // RTC AIE
         rtc_mem[0x0C] |= 0x20;  // signal we generated an interrupt
         assert_irq(ADDR_IRQ1_VECTOR);
     }
@@ -412,6 +595,22 @@ void rtc_update(struct timespec *ts)  // ts isn't really used, but it could be i
 #endif
 }
 
+// Load the RTC with a time in seconds since 1970 (UTC)
+void rtc_set_time(int64_t seconds)
+{
+    time_t t = (time_t) seconds;
+    struct tm tm;
+
+    gmtime_r(&t, &tm);
+    rtc_mem[0] = tm.tm_sec;
+    rtc_mem[2] = tm.tm_min;
+    rtc_mem[4] = tm.tm_hour;
+    rtc_mem[6] = tm.tm_wday + 1;     // RTC uses 1=Sunday
+    rtc_mem[7] = tm.tm_mday;
+    rtc_mem[8] = tm.tm_mon + 1;
+    rtc_mem[9] = tm.tm_year % 100;
+}
+
 /////////////////////////////
 // LCD Controller - HD61830A00
 //
@@ -446,43 +645,7 @@ void rtc_update(struct timespec *ts)  // ts isn't really used, but it could be i
 // https://www.compart.com/en/unicode/category/Sm
 // https://shapecatcher.com
 //
-uint32_t iso_font[32] = {
-/* 00 */  0xe28690,   // ←  e2 86 90  left arrow
-/* 01 */  0xe28692,   // →  e2 86 92  right arrow (seen in sort)
-/* 02 */  0xe29c87,   // ✇  E2 9C 87  tape symbol (should be squarer)
-/* 03 */  0xE29ABF,   // ⚿  E2 9A BF  key symbol
-/* 04 */  0xc397,     // ×  C3 97     times
-/* 05 */  0xc3b7,     // ÷  C3 B7     divide
-/* 06 */  0xe289a0,   // ≠  e2 89 a0  not equals
-/* 07 */  0xF09F9494, // 🔔 F0 9F 94 94 bell character used for alarms (no unicode)
-// 08     0xF09F939E, // 📞 F0 9F 93 9E phone hook symbol seen in status bar
-/* 08 */  0xe2988e,   // ☎  E2 98 8E  phone hook symbol seen in status bar
-/* 09 */  0xe297b7,   // ◷  e2 97 b7  clock symbol when timer is running
-/* 0a */  0xe2908a,   // ␊  e2 90 8a  displayed by password function
-/* 0b */  0xe29780,   // ◀  e2 97 80  filled arrow next to Row and Column indicators
-/* 0c */  0xe2908c,   // ␌  e2 90 8c  FF character
-/* 0d */  0xe2908d,   // ␍  e2 90 8d  displayed by password function
-/* 0e */  0xe2948f,   // ┏  e2 94 8f
-/* 0f */  0xe29493,   // ┓  e2 94 93
-/* 10 */  0xe29497,   // ┗  e2 94 97
-/* 11 */  0xe2949b,   // ┛  e2 94 9b
-/* 12 */  0xe2958b,   // ╋  e2 95 8b  plus
-/* 13 */  0xe294b3,   // ┳  e2 94 b3  T at top of bars
-/* 14 */  0xe294bb,   // ┻  e2 94 bb  upside down T
-/* 15 */  0xe294a3,   // ┣  e2 94 a3
-/* 16 */  0xe294ab,   // ┫  e2 94 ab
-/* 17 */  0xe29483,   // ┃  e2 94 83  thick vertical bar
-/* 18 */  0xe29481,   // ━  e2 94 81  thick horizontal bar
-/* 19 */  0xe29590,   // ═  e2 95 90
-/* 1a */  0xe296a3,   // ▣  e2 96 a3        ◾  e2 97 be -- not working
-/* 1b */  0xe2909b,   // ␛  e2 90 9b  EC character
-/* 1c */  0xc2a9,     // ©  c2 a9  ... this char actually doesn't exist anywhere else!
-                      // special-C = CT char (displays as 0x1c) ... convergent technologies?!
-                      // This is a C in the top left corner, a T in the bottom right.
-                      // also: ␍  e2 90 8d
-/* 1d */  0xe2ac93,   // ⬓  e2 ac 93  Square with bottom half black (Unicode: 0x2b13)
-/* 1e */  0xe297a8,   // ◨  e2 97 a8  Box with filled right  (these 2 seen in WINDOW)
-/* 1f */  0xe296a2};  // ▢  e2 96 a2
+// The Unicode characters the terminal shows for 00-1f (iso_font) are in lcd_font.c.
 
 #ifndef WASM    // not used in WASM
 #if USE_ANSI_XY
@@ -501,9 +664,9 @@ static void init_ansi_screen(void)
     printf("\033[92m\033[100m Calc     \033[30m┃\033[92mFinance \033[30m┃\033[92m Memo   \033[30m┃\033[92m Phone  \033[30m┃\033[92m Time     \033[0m\n");  // FG=green, BG=gray
     printf(        "\033[100m F1       ┃F2      ┃ F3     ┃ F4     ┃ F5       \033[0m\n");
     printf(        "\033[100m                                                \033[0m\n");
-    printf(        "\033[100m F6       ┃F7                                   \033[0m\n");
-//  printf("\033[93m\033[100m Options  ┃Worksheet                            \033[0m\n");  // FG=yellow, BG=gray
-    printf("\033[93m\033[100m Options  \033[30m┃\033[93mWorksheet                            \033[0m\n");  // FG=yellow, BG=gray
+    printf(        "\033[100m F6       ┃F7                        ┃ F8       \033[0m\n");
+//  printf("\033[93m\033[100m Options  ┃Worksheet                 ┃ Power    \033[0m\n");  // FG=yellow, BG=gray
+    printf("\033[93m\033[100m Options  \033[30m┃\033[93mWorksheet                 \033[30m┃\033[93m Power    \033[0m\n");  // FG=yellow, BG=gray
     printf("\nSpecial Key:    Z     X      V     B    N       M\n");
     printf(  "Action:         Find  Print  Save  Get  Recalc  Switch\n");
     printf(  "We map to ctrl- F     P      S     G    R       W\n");
@@ -515,16 +678,80 @@ static void init_ansi_screen(void)
 
 unsigned char lcd_cmd = 0x00;
 uint16_t lcd_cursor_addr = 0x0000;
+unsigned char lcd_mode = 0x00;        // last mode write: cursor shown, blink
 
 #define LCD_RAMSIZE 2048
 unsigned char lcd_ram[LCD_RAMSIZE];
 
+/////////////////////////////
+// LCD frames
+//
+// The firmware's writes only go into lcd_ram and mark the cell dirty.  Once
+// per frame, lcd_refresh() gives the display (lcd_show(): terminal, headless
+// or web) the whole picture in one struct lcd_frame_info, then clears the
+// dirty marks.  The cursor blinks on emulated time, so runs are repeatable.
+
+#define LCD_BLINK_CYCLES  (E_CLOCK_FREQUENCY / 2)    // cursor on or off for 0.5 s
+
+static uint8_t lcd_dirty[LCD_CELLS];      // changed since the last frame
+static int lcd_changes = 0;               // number of cells in lcd_dirty
+static uint8_t lcd_spaces[LCD_CELLS];     // what the display shows while switched off
+static int lcd_blanked = 0;
+
+// What the screen shows: the blank frame while the power is off
+static const uint8_t *lcd_cells(void)
+{
+    return lcd_blanked ? lcd_spaces : lcd_ram;
+}
+
+// Power off blanks the display, but lcd_ram keeps its contents.  The
+// recorder and the watchers get the whole screen it now shows.
+static void lcd_blank(int blank)
+{
+    memset(lcd_spaces, ' ', sizeof(lcd_spaces));
+    memset(lcd_dirty, 1, sizeof(lcd_dirty));
+    lcd_changes = LCD_CELLS;
+    lcd_blanked = blank;
+    if (lcd_watch_on) {
+        lcd_watch_screen(cycle_count, lcd_cells());
+    }
+#ifndef WASM
+    if (lcdrec_on) {
+        lcdrec_screen(cycle_count, lcd_cells(), lcd_cursor_addr, blank ? lcd_mode & ~0x08 : lcd_mode);
+    }
+#endif
+}
+
+void lcd_refresh(void)
+{
+    struct lcd_frame_info f;
+
+    f.cells = lcd_cells();
+    f.dirty = lcd_dirty;
+    f.changes = lcd_changes;
+    f.cursor = lcd_cursor_addr;
+    f.mode = lcd_mode;
+    f.cursor_on = !lcd_blanked && (lcd_mode & 0x08);
+    f.blink = (cycle_count / LCD_BLINK_CYCLES) & 1;
+    f.cycle = cycle_count;
+    lcd_show(&f);
+    if (lcd_changes) {
+        memset(lcd_dirty, 0, sizeof(lcd_dirty));
+        lcd_changes = 0;
+    }
+}
+
+#if !WASM && USE_ANSI_XY
+static void lcd_screen_init(void);
+#endif
+
 static void write_lcd_instr(unsigned char data)  // RS = 1
 {
 #if !WASM && USE_ANSI_XY
     static int first_run = 1;
-    if(first_run) {
+    if(first_run && !lcd_headless) {
         init_ansi_screen();
+        lcd_screen_init();
         first_run = 0;
     }
 #endif
@@ -555,46 +782,119 @@ static unsigned char read_lcd_instr(void)  // RS = 1
 }
 
 #ifndef WASM  // console version
-static void move_cursor(uint16_t p)
-{
+int lcd_headless = 0;                     // don't draw the screen on the terminal
+
 #if USE_ANSI_XY
-    int y = p/46;
-    int x = p%46;
-  #if USE_HEXVIEW
-    x = x * 3;
-  #endif
-    printf("\033[%d;%dH", y+2, x+2);  // extra +1 for border
-#endif
-}
-#else  // WASM version is in workslate-wasm.cpp
-extern void move_cursor(uint16_t p);
+/////////////////////////////
+// Terminal LCD framebuffer
+//
+// Every LCD_FRAME_CYCLES lcd_show() gets the frame, and sends the dirty
+// cells that differ from lcd_shown (what the terminal has), and the cursor,
+// in a single write().  Moves are only sent where the terminal cursor isn't
+// already in the right place, and the UTF-8 for each character is worked out
+// once by lcd_glyphs_init().
+
+#if USE_HEXVIEW
+#define LCD_CELL_WIDTH    3
+#else
+#define LCD_CELL_WIDTH    1
 #endif
 
-#ifndef WASM  // console version
-static void show_cursor(int show)
+static uint8_t lcd_shown[LCD_CELLS];      // what is on the terminal
+static int lcd_screen_ready = 0;          // init_ansi_screen() has drawn the bezel
+static int lcd_redraw = 0;                // compare every cell, not just the dirty ones
+static int lcd_cursor_shown = 1;          // the terminal's cursor starts visible
+
+static char lcd_glyph[128][8];            // UTF-8 (or hex view) for each char
+static uint8_t lcd_glyph_len[128];
+static char lcd_out[LCD_CELLS * 32 + 64];
+
+static void lcd_glyphs_init(void)
 {
-#if USE_ANSI_XY
-    if (show) {
-        printf("\033[?25h"); // show cursor
-    } else {
-        printf("\033[?25l"); // hide cursor
+    for (int c = 0; c < 128; c++) {
+        char *g = lcd_glyph[c];
+        int n = 0;
+#if USE_HEXVIEW
+        n = (c < 0x20) ? sprintf(g, "%02x ", c) : sprintf(g, ".%c ", c);
+#else
+        if (c < 0x20) {
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                if ((iso_font[c] >> shift) || !shift) {
+                    g[n++] = iso_font[c] >> shift;
+                }
+            }
+        } else {
+            g[n++] = c;
+        }
+#endif
+        lcd_glyph_len[c] = n;
     }
-    fflush(stdout);
-#endif    
 }
-#else  // WASM version is in workslate-wasm.cpp
-extern void show_cursor(int show);
-#endif
 
-#ifndef WASM  // console version
-void write_char_at_position(unsigned char data, uint16_t p)
+// Screen has just been cleared and the bezel drawn
+static void lcd_screen_init(void)
 {
-#if USE_ANSI_XY
-    if (data & 0x80) {  // inverse mode
-        printf("\033[7m");
+    lcd_glyphs_init();
+    memset(lcd_shown, ' ', sizeof(lcd_shown));
+    lcd_screen_ready = 1;
+    lcd_redraw = 1;
+}
+
+// Send everything that changed since the last frame
+void lcd_show(const struct lcd_frame_info *f)
+{
+    char *o = lcd_out;
+    int at = -1;              // cell the terminal cursor is at, -1=unknown
+    int inverse = 0;
+    int cursor_on = f->cursor_on && f->cursor < LCD_CELLS;
+
+    if (!lcd_screen_ready) {
+        return;
     }
-#endif
-    move_cursor(p);
+    for (int p = 0; (f->changes || lcd_redraw) && p < LCD_CELLS; p++) {
+        uint8_t data = f->cells[p];
+        if ((!f->dirty[p] && !lcd_redraw) || data == lcd_shown[p]) {
+            continue;
+        }
+        lcd_shown[p] = data;
+        if (p != at) {
+            o += sprintf(o, "\033[%d;%dH", p / LCD_COLS + 2, (p % LCD_COLS) * LCD_CELL_WIDTH + 2);  // +1 for border
+        }
+        if ((data & 0x80) && !inverse) {
+            o += sprintf(o, "\033[7m");
+        } else if (!(data & 0x80) && inverse) {
+            o += sprintf(o, "\033[27m");
+        }
+        inverse = data & 0x80;
+        memcpy(o, lcd_glyph[data & 0x7f], lcd_glyph_len[data & 0x7f]);
+        o += lcd_glyph_len[data & 0x7f];
+        // the border follows the last column, and terminals don't agree on
+        // the width of some of the symbols
+        at = ((p + 1) % LCD_COLS && (data & 0x7f) >= 0x20) ? p + 1 : -1;
+    }
+    lcd_redraw = 0;
+    if (inverse) {
+        o += sprintf(o, "\033[27m");
+    }
+    // the terminal blinks its own cursor, so f->blink isn't needed
+    if (cursor_on && (f->cursor != at || !lcd_cursor_shown)) {
+        o += sprintf(o, "\033[%d;%dH", f->cursor / LCD_COLS + 2,
+                     (f->cursor % LCD_COLS) * LCD_CELL_WIDTH + 2);
+    }
+    if (cursor_on != lcd_cursor_shown) {
+        o += sprintf(o, cursor_on ? "\033[?25h" : "\033[?25l");
+        lcd_cursor_shown = cursor_on;
+    }
+    if (o != lcd_out) {
+        fflush(stdout);   // anything printf'd goes first
+        if (write(fileno(stdout), lcd_out, o - lcd_out) < 0) {
+            // terminal has gone - nothing to do about it
+        }
+    }
+}
+#else  // !USE_ANSI_XY: just print the characters that changed, in order
+static void lcd_print_char(unsigned char data)
+{
     unsigned char c = data & 0x7f;
 #if USE_HEXVIEW
     if (c < 0x20) {
@@ -617,22 +917,88 @@ void write_char_at_position(unsigned char data, uint16_t p)
         printf("%c", c);
     }
 #endif
-#if USE_ANSI_XY
-    if (data & 0x80) {  // inverse mode
-        printf("\033[27m");
+}
+
+void lcd_show(const struct lcd_frame_info *f)
+{
+    if (lcd_headless || !f->changes) {
+        return;
+    }
+    for (int p = 0; p < LCD_CELLS; p++) {
+        if (f->dirty[p]) {
+            lcd_print_char(f->cells[p]);
+        }
     }
-#endif
     fflush(stdout);
 }
-#else  // WASM version is in workslate-wasm.cpp
-extern void write_char_at_position(unsigned char data, uint16_t p);
+#endif // USE_ANSI_XY
+
+int lcd_record_open(const char *filename)
+{
+    return lcdrec_open(filename, E_CLOCK_FREQUENCY);
+}
+
+int lcd_stream_start(const char *path, uint32_t max_fps)
+{
+    return lcd_stream_open(path, max_fps, E_CLOCK_FREQUENCY);
+}
+
+// Every LCD_FRAME_CYCLES: update the terminal, take snapshots (--snapshots),
+// record the cursor (--record-lcd), tell the LCD watchers, and stream the
+// screen (--lcd-socket)
+static void lcd_frame_if_due(void)
+{
+    if (cycle_count - lcd_frame_at >= LCD_FRAME_CYCLES) {
+        lcd_frame_at += LCD_FRAME_CYCLES;
+        lcd_refresh();
+        if (snapshot_on) {
+            snapshot_frame(lcd_cells(), cycle_count);
+        }
+        if (lcdrec_on) {
+            lcdrec_frame(cycle_count);
+        }
+        if (lcd_watch_on) {
+            lcd_watch_frame(cycle_count);
+        }
+        if (lcd_stream_on) {
+            lcd_stream_frame(lcd_cells(), lcd_cursor_addr, lcd_blanked ? lcd_mode & ~0x08 : lcd_mode, cycle_count);
+        }
+    }
+}
+#endif  // WASM: lcd_show() is in workslate-wasm.cpp, and it calls lcd_refresh()
+
+// --record-lcd: pass what the firmware does to the recorder (lcdrec.h),
+// unless the display is blanked
+#ifndef WASM
+#define lcd_record(what, ...)  if (lcdrec_on && !lcd_blanked) { lcdrec_##what(cycle_count, __VA_ARGS__); }
+#else
+#define lcd_record(what, ...)  ;
 #endif
 
+// Write a char at the cursor, which moves on.  Mark it for the next frame,
+// and tell the recorder and the watchers (lcd_watch.h)
+static void lcd_put(uint8_t data)
+{
+    uint16_t addr = lcd_cursor_addr % LCD_RAMSIZE;
+
+    if (addr < LCD_CELLS && lcd_ram[addr] != data && !lcd_dirty[addr]) {
+        lcd_dirty[addr] = 1;
+        lcd_changes++;
+    }
+    lcd_ram[addr] = data;
+    lcd_record(cell, addr, data);
+    if (lcd_watch_on && !lcd_blanked) {
+        lcd_watch_cell(cycle_count, addr, data);
+    }
+    lcd_cursor_addr++;
+}
+
 static void write_lcd_data(unsigned char data)  // RS = 0
 {
     switch (lcd_cmd) {
         case 0x00:           // set mode, blinks, cursor.  Mainly 0x31 (cursor off) or 39 (character blink)
-            show_cursor(data & 0x08);
+            lcd_mode = data;
+            lcd_record(mode, data);
             break;
         case 0x01:
         case 0x02:
@@ -648,7 +1014,8 @@ static void write_lcd_data(unsigned char data)  // RS = 0
             break;
         case 0x0b:  // Set Cursor Address (High Order) (RAM Write High Order Address)
             lcd_cursor_addr = (lcd_cursor_addr & 0x00FF) | ((unsigned short) data << 8);
-            move_cursor(lcd_cursor_addr);
+            lcd_record(cursor, lcd_cursor_addr);
+            lcd_watch_cursor(lcd_cursor_addr);
 #if 0 //  !USE_ANSI_XY
             int y = lcd_cursor_addr/46;  // print this only for commands, not each normal movement
             int x = lcd_cursor_addr%46;
@@ -656,19 +1023,13 @@ static void write_lcd_data(unsigned char data)  // RS = 0
 #endif
             break;
         case 0x0c:  // Write Display Data
-            lcd_ram[lcd_cursor_addr % LCD_RAMSIZE] = data;
-            write_char_at_position(data, lcd_cursor_addr);
-            lcd_cursor_addr++;
+            lcd_put(data);
             break;
         case 0x0e:  // clear bit
-            lcd_ram[lcd_cursor_addr % LCD_RAMSIZE] &= ~(1<< (data & 7));
-            write_char_at_position(lcd_ram[lcd_cursor_addr % LCD_RAMSIZE], lcd_cursor_addr);
-            lcd_cursor_addr++;
+            lcd_put(lcd_ram[lcd_cursor_addr % LCD_RAMSIZE] & ~(1<< (data & 7)));
             break;
         case 0x0f:  // set bits
-            lcd_ram[lcd_cursor_addr % LCD_RAMSIZE] |= 1<< (data & 7);
-            write_char_at_position(lcd_ram[lcd_cursor_addr % LCD_RAMSIZE], lcd_cursor_addr);
-            lcd_cursor_addr++;
+            lcd_put(lcd_ram[lcd_cursor_addr % LCD_RAMSIZE] | 1<< (data & 7));
             break;
         default:
             //  case 0x0d:  // Read display data -- we don't expect a write after this command
@@ -693,58 +1054,48 @@ static unsigned char read_lcd_data(void)  // RS = 0
 /////////////////////////////
 // TAPE PLA simulation
 //
-// There are three registers:
-
+// There are three registers.  CSTAPE0 controls the microcassette, which is
+// emulated by tape.c.  CSTAPE1 has the power-down bit.
 
-uint8_t reg_CSTAPER0;
 uint8_t reg_CSTAPEW0;
 uint8_t reg_CSTAPEW1;
 
-// Bit 0x04 - 1=no tape, 0=tape
-// Bit 0x08 - 1=can record, 0=can't record
 uint8_t read_CSTAPER0(void)
 {
-#if 0 // test code
-    static uint32_t z = 270000;
-    if (z>1) { 
-        z--;
-    } else if (z==1) {
-        printf("\n\n\ntriggering CSTAPER0\n");
-//        reg_CSTAPER0 = reg_CSTAPER0 | 0x02;
-        reg_CSTAPER0 = 0x00;
-        // 0x04 = no tape, can't record
-        // 0x08 = tape, can record
-        // 0x00 = tape, can't record
-        // 0x0C = tape, can't record
-//        ram[ADDR_PORT2] |= 0x01;
-        z--;  // z=0 --> don't trigger again
-    }
-#endif
-    // logit("Read reg_CSTAPER0 - value ", reg_CSTAPER0);
-    return reg_CSTAPER0;
+    // logit(REGLOG_READ, ADDR_TAPE_PLA_2C, tape_status());
+    return tape_status();
 }
 void write_CSTAPEW0(uint8_t data)
 {
-    logit("Write reg_CSTAPEW0 - value ", data);
+    logit(REGLOG_WRITE, ADDR_TAPE_PLA_2C, data);
     reg_CSTAPEW0 = data;
+    tape_control(data);
 }
 
 void write_CSTAPEW1(uint8_t data)
 {
-    logit("Write reg_CSTAPEW1 - value ", data);
-    reg_CSTAPEW0 = data;
+    logit(REGLOG_WRITE, ADDR_TAPE_PLA_2D, data);
+    reg_CSTAPEW1 = data;
 }
 
 
 /////////////////////////////
 // Generic expander port (serial port) emulation
 //
-// TODO: no overflow detection
+// Characters arrive one per SERIAL_CYCLES_DELAY, and the next one isn't
+// started until the firmware has read the last, so the FIFO only overflows
+// if the I/O Box itself sends too much.  That is reported as an overrun
+// (ORFE) and the character is lost, like on the real thing.
+//
+// With serial_fast (--serial-fast) there is no wire delay at all: the next
+// character is ready as soon as the firmware has read the last one, so bulk
+// transfers go as fast as the firmware can take them.  TX already completes
+// immediately.
 #define SERIAL_FIFO_DEPTH 32
 #define SERIAL_CYCLES_DELAY  (E_CLOCK_FREQUENCY / (9600/11))  // 9600 baud, 11 bits/char
+int serial_fast = 0;
 uint32_t serial_rx_fifo_head = 0;
 uint32_t serial_rx_fifo_tail = 0;
-uint32_t serial_cycles_until_next_char = 0;
 uint32_t serial_rx_fifo[SERIAL_FIFO_DEPTH];
 
 int test_serial_rx_fifo_empty(void) {  // internal use only
@@ -763,11 +1114,23 @@ int test_serial_rx_fifo_has_character(void)
     return 1;  // ready!
 }
 
+static uint32_t serial_rx_fifo_count(void)
+{
+    return (serial_rx_fifo_head + SERIAL_FIFO_DEPTH - serial_rx_fifo_tail) % SERIAL_FIFO_DEPTH;
+}
+
 void push_serial_rx_fifo(uint8_t c)
 {
+    if (serial_rx_fifo_count() == SERIAL_FIFO_DEPTH - 1) {   // full
+        ram[ADDR_TRCSR] |= 0x40;  // set ORFE
+        if (ram[ADDR_TRCSR] & 0x10) {
+            assert_irq(ADDR_SCI_VECTOR);
+        }
+        return;
+    }
     if(test_serial_rx_fifo_empty()) {
         // kick off timer for first character
-        serial_cycles_until_next_char = SERIAL_CYCLES_DELAY;
+        serial_cycles_until_next_char = serial_fast ? 0 : SERIAL_CYCLES_DELAY;
     }
 
     serial_rx_fifo[serial_rx_fifo_head] = c;
@@ -782,13 +1145,68 @@ uint8_t pull_serial_rx_fifo(void)
     uint8_t retval = serial_rx_fifo[serial_rx_fifo_tail];
     serial_rx_fifo_tail = (serial_rx_fifo_tail + 1) % SERIAL_FIFO_DEPTH;
 
+#ifndef WASM
+    if (serial_bridge_on) {
+        poll_serial_host();
+    }
+#endif
     if(!test_serial_rx_fifo_empty()) {
         // kick off timer for next character
-        serial_cycles_until_next_char = SERIAL_CYCLES_DELAY;
+        serial_cycles_until_next_char = serial_fast ? 0 : SERIAL_CYCLES_DELAY;
     }
     return retval;
 }
 
+/////////////////////////////
+// Serial bridge to the host (--serial)
+//
+// Bytes from the host are only moved into the FIFO while it is less than half
+// full, leaving room for the I/O Box's own replies; the rest wait in the
+// bridge, and then in the host's kernel, until the firmware catches up.  In
+// the other direction TDRE stays clear while the bridge (or the print
+// spooler) is full.
+
+static int serial_tx_blocked = 0;   // TX interrupt is owed once the bridge has room
+
+static int serial_tx_ready(void)
+{
+#ifndef WASM
+    if (serial_bridge_on && !serial_bridge_tx_ready()) {
+        return 0;
+    }
+    if (spooler_on && !spooler_ready()) {
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+#ifndef WASM
+static uint64_t emulated_msec(void)
+{
+    return cycle_count * 1000 / E_CLOCK_FREQUENCY;
+}
+
+static void poll_serial_host(void)
+{
+    int c;
+
+    while (serial_bridge_on && serial_rx_fifo_count() < SERIAL_FIFO_DEPTH / 2
+           && (c = serial_bridge_get()) >= 0) {
+        push_serial_rx_fifo(c);
+    }
+    if (spooler_on) {
+        spooler_tick(emulated_msec());
+    }
+    if (serial_tx_blocked && serial_tx_ready()) {
+        serial_tx_blocked = 0;
+        if (ram[ADDR_TRCSR] & 0x04) {
+            assert_irq(ADDR_SCI_VECTOR);
+        }
+    }
+}
+#endif
+
 /////////////////////////////
 // Printer Emulation
 //
@@ -808,6 +1226,18 @@ void wk2serial(uint8_t ch)
             push_serial_rx_fifo(ID_string_serial[i]);
         }
     }
+#ifndef WASM
+    else if (serial_bridge_on || spooler_on)
+    {
+        // only called when serial_tx_ready(), so there is room
+        if (spooler_on) {
+            spooler_put(ch, emulated_msec());
+        }
+        if (serial_bridge_on) {
+            serial_bridge_put(ch);
+        }
+    }
+#endif
     else
     {
         push_serial_rx_fifo(ch);  // echo back (testing)
@@ -821,19 +1251,17 @@ void wk2serial(uint8_t ch)
 // Power on is handled by hardware and is basically a reset.
 // Power off is requested by the software
 //
-// Note: power is only supported for WASM mode.  This is because
-// in terminal mode, we only scan the unix keyboard when the software request it.
-// When powered off (SLP mode), we don't scan that so we can't turn on.
+// Once off, the firmware sits in SLP with interrupts masked until the power
+// key is pressed.  The terminal version doesn't emulate that: cpu_sleeping()
+// calls power_dormant(), which waits on the keyboard for F8 (power) instead
+// of stepping through the SLP, so a switched-off emulator uses no host CPU.
+// The RTC has its own battery, so power on resets everything but the RTC.
 
 int power_is_on = 0;
 
 void power_off_requested(void)
 {
-    // clear screen
-    show_cursor(0);
-    for(uint16_t p=0; p<46*16; p++) {
-        write_char_at_position(' ', p);
-    }
+    lcd_blank(1);   // clear screen
     // next CPU instruction will be SLP, so let CPU emulator handle that.
     power_is_on = 0;
 }
@@ -841,15 +1269,64 @@ void power_off_requested(void)
 void power_on_requested(void)
 {
     power_is_on = 1;
+    lcd_blank(0);
     
-    // clear keyboard fifo
-    clear_kbd_fifo();
+    // let go of all keys
+    kbd_clear();
 
     // reset
-    workslate_hw_reset();
+    power_up_reset();
     pc = ((mread(0xFFFE) << 8) + mread(0xFFFF));
 }
 
+#ifndef WASM
+// One step of being switched off: wait for the power key, up to the next
+// frame (or the next virtual RTC second).  Other keys do nothing while the
+// power is off.  The RTC is battery backed, so emulated time goes on: the
+// host waits it out in real time, except that virtual time at an unthrottled
+// speed jumps straight over it to reach a --cycles limit.  (With no limit
+// there is nothing to hurry for, and it would only spin the host and race the
+// RTC.)  Returns after each step, so sim() still stops at its cycle limit,
+// and Ctrl-C still gets to the monitor.
+static void power_dormant(void)
+{
+    uint32_t event;
+    uint32_t n;
+    int second_rolled;
+
+    lcd_frame_if_due();   // the blank screen, snapshots, etc. go on
+    n = LCD_FRAME_CYCLES - (uint32_t) (cycle_count - lcd_frame_at);
+    if (virtual_time && E_CLOCK_FREQUENCY - virtual_rtc_cycles < n) {
+        n = E_CLOCK_FREQUENCY - virtual_rtc_cycles;
+    }
+    if (virtual_time && (pacing_get_speed() || sim_cycle_limit)) {
+        n = pacing_idle(n, &second_rolled);
+    } else {
+        n = pacing_wait_input(n, &second_rolled);
+    }
+
+    // the CPU and its timers are reset at power on, only the RTC counts
+    cycles_simulated_this_tick += n;
+    cycle_count += n;
+    if (virtual_time && (virtual_rtc_cycles += n) >= E_CLOCK_FREQUENCY) {
+        virtual_rtc_cycles = 0;
+        rtc_update(NULL);       // an emulated second has passed
+    }
+    if (second_rolled && !virtual_time) {
+        rtc_update(NULL);       // a host second has passed
+    }
+
+    while (!power_is_on && kbd_reader_get(&event)) {
+        if (event & KBD_POWER) {
+            kbd_event(event);   // turns us on
+        }
+    }
+    if (!power_is_on) {
+        pacing_input_ready = 0;  // all taken
+    }
+}
+#endif
+
 /////////////////////////////
 // Keyboard
 //
@@ -893,244 +1370,215 @@ void power_on_requested(void)
 // 7| zxcvbnm;
 
 
-#define KBD_FIFO_DEPTH 32
-uint32_t kbd_fifo_head = 0;
-uint32_t kbd_fifo_tail = 0;
-uint32_t kbd_fifo[KBD_FIFO_DEPTH];  // 00 00 pp rr  (pp=probe, rr=response)
+// The keyboard is kept as a matrix: kbd_matrix[column] has a bit set for
+// each row with a key down.  Key words are 00 0s pp rr (pp=probe column,
+// rr=response row, s=KBD_SHIFT/KBD_SPECIAL/KBD_POWER), and several keys can
+// be held at once.  kbd_response[] has the answer to every probe
+// (scan_enable) value ready, so a read is one table lookup.
+//
+// Typed keys become press and release events in kbd_queue.  An event is
+// only applied at the start of a full scan (the firmware first probes all
+// columns at once), so a scan never sees the keys change half way through,
+// and only once the last change has been held for KBD_HOLD_CYCLES: long
+// enough for the firmware's debounce.  If the facts file says where the
+// firmware's key buffer is (terminal version), presses also wait until it is
+// empty, so keys typed ahead while the firmware is busy aren't lost.  With
+// --fast-keys the firmware decides instead (see kbd_state_done()).  When the
+// queue is full, kbd_event() fails and the caller holds on to the rest.
+
+#define KBD_QUEUE_DEPTH   4096                     // power of 2
+#define KBD_HOLD_CYCLES   (E_CLOCK_FREQUENCY / 10) // about 10 scans
+
+static uint32_t kbd_queue[KBD_QUEUE_DEPTH];
+static uint32_t kbd_queue_head = 0;
+static uint32_t kbd_queue_tail = 0;
+static uint8_t kbd_matrix[8];
+static uint8_t kbd_response[256];
+static uint64_t kbd_changed_at = 0;    // cycle_count when the matrix last changed
+
+static int kbd_queue_full(void)
+{
+    return kbd_queue_head - kbd_queue_tail == KBD_QUEUE_DEPTH;
+}
 
-void push_kbd_fifo(uint32_t f)
+// Queue a press of keys, or a release (KBD_RELEASE | keys, or just
+// KBD_RELEASE for all keys).  Returns -1 if the queue is full
+int kbd_event(uint32_t event)
 {
-    // Power key is acted on immediately & not pushed in to fifo
-    if(f & 0x40000) {  // if power key
+    // Power key is acted on immediately & not queued
+    if((event & KBD_POWER) && !(event & KBD_RELEASE)) {
         if(power_is_on) {
             // tell software the user wants to shut down
             ram[ADDR_PORT1] = ram[ADDR_PORT1] & 0xFB;  // clear bit 2
         } else {
             power_on_requested();
         }
-        return;
+        return 0;
+    }
+    if (kbd_queue_full()) {
+        return -1;
     }
+    kbd_queue[kbd_queue_head++ % KBD_QUEUE_DEPTH] = event;
+    return 0;
+}
 
-    kbd_fifo[kbd_fifo_head] = f;
-    kbd_fifo_head = (kbd_fifo_head + 1) % KBD_FIFO_DEPTH;
+static void kbd_set(uint8_t probe, uint8_t response, int down)
+{
+    for (int col = 0; col < 8; col++) {
+        if (probe & (1 << col)) {
+            kbd_matrix[col] = down ? (kbd_matrix[col] | response) : (kbd_matrix[col] & ~response);
+        }
+    }
 }
 
-void clear_kbd_fifo(void)
+static void kbd_apply(uint32_t event)
 {
-    kbd_fifo_head = 0;
-    kbd_fifo_tail = 0;
+    int down = !(event & KBD_RELEASE);
+
+    if (event == KBD_RELEASE) {
+        memset(kbd_matrix, 0, sizeof(kbd_matrix));
+    }
+    kbd_set(event >> 8, event & 0xFF, down);
+    if (event & KBD_SHIFT) {
+        kbd_set(0x01, 0x08, down);   // code for shift is 0x0108
+    }
+    if (event & KBD_SPECIAL) {
+        kbd_set(0x02, 0x20, down);   // code for "special" is 0x0220
+    }
+
+    // At first the scan_enable is 0xFF to check for any key pressed.
+    // Then it is a single bit to narrow in on exact character(s)
+    for (int scan_enable = 0; scan_enable < 256; scan_enable++) {
+        uint8_t r = 0;
+        for (int col = 0; col < 8; col++) {
+            if (scan_enable & (1 << col)) {
+                r |= kbd_matrix[col];
+            }
+        }
+        kbd_response[scan_enable] = r;
+    }
+    kbd_changed_at = cycle_count;
+}
+
+void kbd_clear(void)
+{
+    kbd_queue_head = 0;
+    kbd_queue_tail = 0;
+    kbd_apply(KBD_RELEASE);
 }
 
 #ifndef WASM
+// Move typed keys from the keyboard reader thread into the queue
 static void kbd_read_terminal(void)
 {
-    int flags;
-    unsigned char c1,c2,c3,c4,c5;
-    uint64_t inkey;
-    int rtn;
-
-    flags = fcntl(fileno(stdin), F_GETFL);
-    if (flags == -1) {
-        perror("fcntl error");
-        exit(-1);
-    }
-    fcntl(fileno(stdin), F_SETFL, flags | O_NONBLOCK);
-    // TODO: don't read if we don't have room in FIFO
-    rtn = read(fileno(stdin), &c1, 1);
-
-    if(rtn != 1) {
-        fcntl(fileno(stdin), F_SETFL, flags);
-        return;  // no key press
-    }
-
-    inkey = c1;
-    if(c1 == 0x1b) {  // if ESC, then check if just an ESC or an 3-char escape sequence
-        rtn = read(fileno(stdin), &c2, 1);
-        if(rtn == 1) {
-            inkey = (inkey << 8) | c2;  // second char of sequence
-            rtn = read(fileno(stdin), &c3, 1);
-            if(rtn == 1) {
-                inkey = (inkey << 8) | c3;  // third char of sequence
-                rtn = read(fileno(stdin), &c4, 1);
-                if(rtn == 1) {
-                    inkey = (inkey << 8) | c4;  // fourth char of sequence
-                    rtn = read(fileno(stdin), &c5, 1);
-                    if(rtn == 1) {
-                        inkey = (inkey << 8) | c5;  // fifth char of sequence
-                    }
-               }
-            }
+    uint32_t event;
+    uint64_t key;
+
+    if (!pacing_input_ready) {
+        return;  // nothing typed (checked by pacing.c, so we don't look at the queue here)
+    }
+    while (kbd_reader_unknown(&key)) {
+        printf("[UNKNOWN KEY IN %02llX]", (unsigned long long) key);
+        fflush(stdout);
+    }
+    while (!kbd_queue_full()) {
+        if (!kbd_reader_get(&event)) {
+            pacing_input_ready = 0;  // all taken
+            return;
         }
+        kbd_event(event);
     }
-    fcntl(fileno(stdin), F_SETFL, flags);
-
-    int shift_key = 0;
-    int special_key = 0;
-    if ((inkey >= 'A') && (inkey <= 'Z')) {
-        inkey = inkey - 'A' + 'a';
-        shift_key = 1;
-    }
-
-    uint32_t f = 0;
-    switch(inkey) {
-        case 'a': f = 0x0110; break;
-        case 'b': f = 0x1080; break;
-        case 'g'-0x60: f = 0x1080; special_key = 1; break;  // special-B --> Get
-        case 'c': f = 0x0480; break;
-//      case ???: f = 0x0480; special_key = 1; break;  // special-C = CT char (displays as 0x1c)
-        case 'd': f = 0x0410; break;
-        case 'e': f = 0x0401; break;
-        case '#': f = 0x0401; special_key = 1; break;  // special-E
-        case 'f': f = 0x0810; break;
-        case '\\':f = 0x0810; special_key = 1; break;  // special-F
-        case 'g': f = 0x1010; break;
-        case '^': f = 0x1010; special_key = 1; break;  // special-G
-        case 'h': f = 0x2010; break;
-        case '_': f = 0x2010; special_key = 1; break;  // special-H
-        case 'i': f = 0x8001; break;
-     // case    : f = 0x8001; special_key = 1; break;  // special-I  This shows as a '-', same as the subtract!
-        case 'j': f = 0x4010; break;
-        case '|': f = 0x4010; special_key = 1; break;  // special-J
-        case 'k': f = 0x8010; break;
-        case '~': f = 0x8010; special_key = 1; break;  // special-K
-        case 'l': f = 0x8004; break;
-//      case ???: f = 0x8004; special_key = 1; break;  // special-L is a big solid box
-        case 'm': f = 0x4080; break;
-        case 'w'-0x60: f = 0x4080; special_key = 1; break;  // special-M--> Switch
-        case 'n': f = 0x2080; break;
-        case 'r'-0x60: f = 0x2080; special_key = 1; break;  // special-N --> Recalc
-        case 'o': f = 0x8002; break;
-        case '?': f = 0x8002; special_key = 1; break;  // special-O
-        case 'p': f = 0x4002; break;
-        case 'd'-0x60: f = 0x4002; special_key = 1; break;  // special-P -- actually '/' but we map that to divide
-        case 'q': f = 0x0101; break;
-        case '!': f = 0x0101; special_key = 1; break;  // special-Q
-        case 'r': f = 0x0801; break;
-        case '&': f = 0x0801; special_key = 1; break;  // special-R
-        case 's': f = 0x0210; break;
-        case '`': f = 0x0210; special_key = 1; break;  // special-S
-        case 't': f = 0x1001; break;
-        case 'a'-0x60: f = 0x1001; special_key = 1; break;  // special-T -- actually '*' but we map that to times
-        case 'u': f = 0x4001; break;
-        case '\"':f = 0x4001; special_key = 1; break;  // special-U
-        case 'v': f = 0x0880; break;
-        case 's'-0x60: f = 0x0880; special_key = 1; break;  // special-V --> Save
-        case 'w': f = 0x0201; break;
-        case '@': f = 0x0201; special_key = 1; break;  // special-W
-        case 'x': f = 0x0280; break;
-        case 'p'-0x60: f = 0x0280; special_key = 1; break;  // special-X --> Print
-        case 'y': f = 0x2001; break;
-        case '\'':f = 0x2001; special_key = 1; break;  // special-Y
-        case 'z': f = 0x0180; break;
-        case 'f'-0x60: f = 0x0180; special_key = 1; break;  // special-Z --> Find
-        case '0': f = 0x8040; break;
-        case '<': f = 0x8040; special_key = 1; break;  // special-0
-        case '1': f = 0x0140; break;
-        case '[': f = 0x0140; special_key = 1; break;  // special-1
-        case '2': f = 0x0240; break;
-        case ']': f = 0x0240; special_key = 1; break;  // special-2
-        case '3': f = 0x0440; break;
-        case 'n'-0x60: f = 0x0440; special_key = 1; break;  // special 3 -- not equals
-        case '4': f = 0x1004; break;
-        case '(': f = 0x1004; special_key = 1; break;  // special-4
-        case '5': f = 0x0804; break;
-        case ')': f = 0x0804; special_key = 1; break;  // special-5
-        case '6': f = 0x0404; break;
-        case '%': f = 0x0404; special_key = 1; break;  // special-6
-        case '7': f = 0x1002; break;
-        case '{': f = 0x1002; special_key = 1; break;  // special-7
-        case '8': f = 0x0102; break;
-        case '}': f = 0x0102; special_key = 1; break;  // special-8
-        case '9': f = 0x0202; break;
-        case '$': f = 0x0202; special_key = 1; break;  // special-9
-        case ',': f = 0x8080; break;                   // (near letters not numpad) not in chart
-        case ';': f = 0x8080; special_key = 1; break;  // special , ERROR: returns ,,,,,,,
-        case '.': f = 0x4040; break;  // numpad
-    // ^^ SAW SOMETHING ODD IN MEMO ONCE
-        case '>': f = 0x4040; special_key = 1; break;  // special-.
-        //            0x2004;         // duplicate '.' key next to L  -- we don't use
-        case ':': f = 0x2004; special_key = 1; break; // ERROR: returns ....
-        case '=': f = 0x2040; break;  // aka "Formula"
-    // ^^ SAW SOMETHING ODD IN MEMO ONCE
-        case '+': f = 0x1040; break;
-        case '-': f = 0x0840; break;
-        case '/': f = 0x0802; break;  // divide character
-        case '*': f = 0x0402; break;  // multiply character
-        case ' ': f = 0x0420; break;  // space bar
-        case 0x0D:f = 0x0820; break;  // Enter-->DoIt
-        case 0x7F:f = 0x2002; break;  // backspace
-        case 0x1b:f = 0x0208; break;  // ESC --->Cancel
-        case 0x1b5b41:f = 0x1020; break;  // up
-        case 0x1b5b42:f = 0x8020; break;  // down
-        case 0x1b5b43:f = 0x2020; break;  // right
-        case 0x1b5b44:f = 0x4020; break;  // left
-        case     0x1b4f50:f = 0x0408; break;  // F1 -->    Calc soft key
-        case     0x1b4f51:f = 0x0808; break;  // F2 --> Finance soft key
-        case     0x1b4f52:f = 0x1008; break;  // F3 -->    Memo soft key
-        case     0x1b4f53:f = 0x4008; break;  // F4 -->   Phone soft key
-        case 0x1b5b31357e:f = 0x2008; break;  // F5 -->    Time soft key
-
-        case 0x1b5b31377e:f = 0x8008; break;  // F6 -->      Options key
-        case 0x1b5b31387e:f = 0x0120; break;  // F7 -->    Worksheet key
-        // "Special" key is       0220 but it acts like a shift key
-        default: printf("[UNKNOWN KEY IN %02llX]", inkey); fflush(stdout);
-    }
-    if (shift_key) {
-        // jam in just the shift key being pressed
-        push_kbd_fifo(0x10000);    // bit 16 is the shift key
-        // then jam in the combo next
-        f = f | 0x10000;
-    }
-    if (special_key) {
-        // jam in just the special key being pressed
-        push_kbd_fifo(0x20000);  // bit 17 is the special key
-        // then jam in the combo next
-        f = f | 0x20000;
-    }
-    if (f) {  // stuff in fifo
-        push_kbd_fifo(f);
-    }
-    // stuff no-keys-pressed in fifo
-    push_kbd_fifo(0);
 }
-#endif
 
+/////////////////////////////
+// Fast key feeding (--fast-keys)
+//
+// Instead of holding every change for KBD_HOLD_CYCLES, watch the firmware's
+// scan routine (KEY_SCAN) and move on as soon as it is done with the keys:
+//   - a key: when the scan routine latches it into KEY_BUFFER (KEY_COUNT goes
+//     up).  Keys the firmware doesn't use are never latched, so give up on
+//     them after KBD_GIVE_UP_SCANS scans.
+//   - no keys: after one full scan has seen the keyboard empty, and the
+//     firmware has taken all the keys in KEY_BUFFER.  A key pressed while the
+//     buffer is full isn't latched until it auto-repeats, so this is what
+//     makes type-ahead reliable.
+//   - shift or special alone: these are never latched, so after the
+//     KBD_DEBOUNCE_SCANS scans the firmware needs to see a steady state.
+
+#define KBD_DEBOUNCE_SCANS  3
+#define KBD_GIVE_UP_SCANS   10
+
+int kbd_fast = 0;
+static int key_count_addr = -1;   // KEY_COUNT - checked by mwrite()
+static int kbd_latched = 0;       // the firmware has taken the key being held
+static int kbd_scans = 0;         // full scans since the last change
+
+static int find_fact(const char *label);
+
+// Call after loading the facts file.  Returns -1 if it doesn't have the labels
+int kbd_init(void)
+{
+    key_count_addr = find_fact("KEY_COUNT");
+    if (key_count_addr < 0) {
+        if (kbd_fast) {
+            printf("Fast keys need KEY_COUNT in the facts file\n");
+        }
+        return -1;
+    }
+    return 0;
+}
+
+static int kbd_buffer_empty(void)
+{
+    return key_count_addr < 0 || ram[key_count_addr] == 0;
+}
+
+// Called at the start of each full scan
+static int kbd_state_done(void)
+{
+    int modifiers = ((kbd_matrix[0] & 0x08) ? 1 : 0) + ((kbd_matrix[1] & 0x20) ? 1 : 0);
+    int keys_down = 0;
+
+    for (int col = 0; col < 8; col++) {
+        keys_down += __builtin_popcount(kbd_matrix[col]);
+    }
 
+    kbd_scans++;
+    if (keys_down > modifiers) {
+        return kbd_latched || kbd_scans >= KBD_GIVE_UP_SCANS;
+    }
+    if (keys_down) {
+        return kbd_scans >= KBD_DEBOUNCE_SCANS;
+    }
+    return kbd_buffer_empty();
+}
+#endif
 
 unsigned char read_kbd(unsigned char scan_enable)
 {
-    static int timer = 0;
-
 #ifndef WASM
     kbd_read_terminal();
 #endif
-    if(kbd_fifo_head == kbd_fifo_tail) {
-        return 0;  // fifo empty
-    }
-    if(timer++ > 200) {
-        // this key has been read enough; time to move on to next key
-        kbd_fifo_tail = (kbd_fifo_tail + 1) % KBD_FIFO_DEPTH;
-        timer = 0;
-        if(kbd_fifo_head == kbd_fifo_tail) {
-            return 0;  // fifo empty
+    if (scan_enable == 0xFF && kbd_queue_head != kbd_queue_tail) {   // start of a scan, and keys are waiting
+#ifndef WASM
+        // only a press waits for the key buffer: a release held back would
+        // leave the key down long enough to auto-repeat
+        uint32_t event = kbd_queue[kbd_queue_tail % KBD_QUEUE_DEPTH];
+        int done = kbd_fast ? kbd_state_done()
+                            : cycle_count - kbd_changed_at >= KBD_HOLD_CYCLES &&
+                              ((event & KBD_RELEASE) || kbd_buffer_empty());
+#else
+        int done = cycle_count - kbd_changed_at >= KBD_HOLD_CYCLES;
+#endif
+        if (done) {
+            kbd_apply(kbd_queue[kbd_queue_tail++ % KBD_QUEUE_DEPTH]);
+#ifndef WASM
+            kbd_latched = 0;
+            kbd_scans = 0;
+#endif
         }
     }
-    // Let this key be pressed for 200 reads
-    // At first the scan_enable is 0xFF to check for any key pressed.
-    // Then it is a single bit to narrow in on exact character(s)
-    unsigned char retval = 0;
-    uint8_t shift_key_pressed = (kbd_fifo[kbd_fifo_tail] >> 16) & 1;
-    uint8_t special_key_pressed = (kbd_fifo[kbd_fifo_tail] >> 16) & 2;
-    uint8_t probe_column      = kbd_fifo[kbd_fifo_tail] >> 8;
-    uint8_t response_row      = kbd_fifo[kbd_fifo_tail] & 0xFF;
-    retval = (scan_enable & probe_column) ? response_row : 0;
-    if(shift_key_pressed && (scan_enable & 0x01)) {
-        retval |= 0x08;   // code for shift is 0x0108, but only appears when scanning its column
-    }
-    if(special_key_pressed && (scan_enable & 0x02)) {
-        retval |= 0x20;   // code for "special" is 0x0220, but only appears when scanning its column
-    }
-    return retval;
+    return kbd_response[scan_enable];
 }
 
 /////////////////////////////
@@ -1179,7 +1627,7 @@ unsigned char mread_raw(unsigned short addr)
     } else {  // it's IO
         // printf("I/O MEMORY READ  - addr %04x\n", addr);
         switch(addr) {
-            case ADDR_PORT2:     case ADDR_PORT3:     case ADDR_PORT4:
+                                 case ADDR_PORT3:     case ADDR_PORT4:
                                  case ADDR_PORT3_DDR: case ADDR_PORT4_DDR:
             case ADDR_RMCR:    // SCI Rate and Mode Control Register  (only lower 4 bits)
             case ADDR_OCHR:      case ADDR_OCLR:     // Output compare register
@@ -1188,6 +1636,8 @@ unsigned char mread_raw(unsigned short addr)
             case ADDR_PORT1_DDR: case ADDR_PORT2_DDR:
                 return 0xFF; // sometimes used as a trick to inc/dec D register - must be $FF for this write-pnly reg.
                 // Workslate doesn't seem to use this trick.
+            case ADDR_PORT2:
+                return (ram[addr] & ~0x01) | tape_in_level();  // P20 is the tape playback signal
             case ADDR_TAPE_PLA_2C:
                 return read_CSTAPER0();
             case ADDR_PORT1:
@@ -1195,11 +1645,11 @@ unsigned char mread_raw(unsigned short addr)
                 return ram[addr] | 0x08; // Force ring-indicator off (TODO: make read-only bits of PORT1 seperate from write parts)
             case ADDR_TRCSR:   // Transmit/Receive Control and Status Register
                 deassert_irq(ADDR_SCI_VECTOR);  // not exactly by the book - disables too early!
-                return (ram[addr] | 0x20);  // ok to TX
+                return ram[addr] | (serial_tx_ready() ? 0x20 : 0);  // TDRE: ok to TX
             case ADDR_SCRDR:  // SCI Receiver Data Register
-                ram[ADDR_TRCSR] = ram[ADDR_TRCSR] & 0x7F;  // clear RX ready bit
+                ram[ADDR_TRCSR] = ram[ADDR_TRCSR] & 0x3F;  // clear RX ready and overrun bits
                 ch = pull_serial_rx_fifo();
-                logit("RX Char", ch);
+                logit(REGLOG_READ, ADDR_SCRDR, ch);
                 return ch;
             // Timer
             case ADDR_CHR:     // 0x09                 // free-running counter
@@ -1211,6 +1661,12 @@ unsigned char mread_raw(unsigned short addr)
                 return ram[addr];                      // return latched value
             case ADDR_TCSR:   // TODO
                 return ram[addr];
+            case ADDR_ICHR:    // input capture
+                ram[ADDR_TCSR] &= ~0x80;               // clear ICF flag (actually requires TCSR read first but we assume that happened)
+                deassert_irq(ADDR_ICF_VECTOR);
+                return ram[addr];
+            case ADDR_ICLR:
+                return ram[addr];
             // Keyboard
             case ADDR_KBD:
                 return read_kbd(ram[ADDR_KBD]);
@@ -1235,11 +1691,35 @@ unsigned char mread(unsigned short addr)
     return mread_raw(addr);
 }
 
+// For the monitor and tools: what a read in the given ROM bank would see,
+// without touching the hardware.  I/O registers just give what was last
+// written to them; the RTC gives what a read would, but REG C isn't cleared.
+unsigned char mpeek(unsigned char bank, unsigned short addr)
+{
+    if ((addr >= ADDR_RTC_START) && (addr <= ADDR_RTC_END)) {
+        return peek_rtc(addr - ADDR_RTC_START);
+    } else if (addr < RAMSIZE) {
+        return ram[addr];
+    } else if (addr >= ROMSTART) {
+        switch(bank & 0x03) {
+            case 3:  return rom_u16[addr - ROMSTART];
+            case 2:  return rom_u15[addr - ROMSTART];
+            case 1:  return rom_u14[addr - ROMSTART];
+        }
+    }
+    return 0xFF;
+}
+
 /* All memory writes go through this function */
 void mwrite(unsigned short addr, unsigned char data)
 {
     advance_cycle(); // count cycles & operate timers
     if((addr >= 0x80) && (addr < RAMSIZE)) {
+#ifndef WASM
+        if (addr == key_count_addr && data > ram[addr]) {
+            kbd_latched = 1;   // the scan routine has taken a key
+        }
+#endif
         ram[addr] = data;  // RAM Write
         return;
     } else if (addr >= ROMSTART) {
@@ -1265,19 +1745,16 @@ void mwrite(unsigned short addr, unsigned char data)
                 ram[addr] = (ram[addr] & 0x04) | (data & 0xFB);
                 break;
             case ADDR_TRCSR:   // Transmit/ Receive Control and Status Register
-                logit("Write TRCSR", data);
-                ram[addr] = data;
+                logit(REGLOG_WRITE, ADDR_TRCSR, data);
+                ram[addr] = (ram[addr] & 0xC0) | (data & 0x1F);  // RDRF and ORFE are read-only
                 break;
             case ADDR_SCTDR: // SCI Transmit Data Register - used with "Print" command
-                logit("TX Char", data);
-#if 0
-                FILE *ff = fopen("tx_log.txt","a");
-                fprintf(ff, "%c", data);
-                fclose(ff);
-#endif
+                logit(REGLOG_WRITE, ADDR_SCTDR, data);
                 wk2serial(data);  // assume connected to serial port, not printer TODO: multiplex
                 // assume that it goes out immediately ... so check if tx interrupt enabled
-                if(ram[ADDR_TRCSR] & 0x04) {
+                if (!serial_tx_ready()) {
+                    serial_tx_blocked = 1;
+                } else if(ram[ADDR_TRCSR] & 0x04) {
                     assert_irq(ADDR_SCI_VECTOR);
                 }
                 break;
@@ -1326,11 +1803,114 @@ void mwrite(unsigned short addr, unsigned char data)
 
 
 
-/* All jumps go through this function */
+/////////////////////////////
+// High-level tape
+//
+// With a high-level tape in (--tape-hl), the firmware's serial driver is
+// short-circuited while it has the tape channel open.  Its put/get char
+// routines are simulated and move bytes straight between the firmware and the
+// host file, instead of clocking them through the SCI and the tape mechanism.
+// The entry points come from the facts file, by label.
+
 unsigned short pull2();
+
+#ifndef WASM
+
+static int sci_open_addr = -1;
+static int sci_putc_addr = -1;
+static int sci_getc_addr = -1;
+static int sci_channel_addr = -1;
+
+static int find_fact(const char *label)
+{
+    for (int addr = 0; addr < 65536; addr++) {
+        if (facts[addr] && !strcmp(facts[addr]->label, label)) {
+            return addr;
+        }
+    }
+    return -1;
+}
+
+// Call after loading the facts file.  Returns -1 if it doesn't have the labels
+int tape_hl_init(void)
+{
+    sci_open_addr = find_fact("SCI_OPEN");
+    sci_putc_addr = find_fact("SCI_PUTC");
+    sci_getc_addr = find_fact("SCI_GETC");
+    sci_channel_addr = find_fact("SCI_CHANNEL");
+    if (sci_open_addr < 0 || sci_putc_addr < 0 || sci_getc_addr < 0 || sci_channel_addr < 0) {
+        printf("High-level tape needs SCI_OPEN, SCI_PUTC, SCI_GETC and SCI_CHANNEL in the facts file\n");
+        return -1;
+    }
+    return 0;
+}
+
+// return from the simulated subroutine
+static void simulated_rts(void)
+{
+    pc = pull2();
+}
+
+// Channel descriptors start with the type.  2=tape
+static int is_tape_channel(unsigned short descriptor)
+{
+    return mpeek(get_bank(), descriptor) == 2;
+}
+
+// The driver's status in B, with the flags as LDAB would leave them
+static void driver_status(unsigned char b)
+{
+    accb = b;
+    z_flag = (b == 0);
+    n_flag = (b >> 7) & 1;
+    v_flag = 0;
+}
+
+static void tape_hl_intercept(unsigned short addr)
+{
+    int ch;
+
+    if (addr == sci_open_addr) {
+        if (is_tape_channel(ix)) {   // X=channel descriptor.  Let the driver open it as usual
+            tape_hl_seek();
+        }
+    } else if (!is_tape_channel((mpeek(get_bank(), sci_channel_addr) << 8) | mpeek(get_bank(), sci_channel_addr + 1))) {
+        return;
+    } else if (addr == sci_putc_addr) {
+        // On a write error the tape is ejected, and "buffer full" sends the
+        // firmware back to the real driver, which finds no tape
+        driver_status(tape_hl_put(acca) ? 1 : 0);
+        simulated_rts();
+    } else if (addr == sci_getc_addr) {
+        ch = tape_hl_get();
+        if (ch < 0) {
+            driver_status(1);   // nothing received
+        } else {
+            acca = ch;
+            driver_status(0);
+        }
+        simulated_rts();
+    }
+}
+#endif // WASM
+
+/* JSR and BSR come here, after pushing the return address */
+void jump_subroutine(unsigned short addr)
+{
+    pc = addr;
+#ifndef WASM
+    // Only calls are intercepted: simulated_rts() needs the return address
+    // on the stack, and the driver branches back into its own entry points
+    if (tape_hl_active() && get_bank() == 3) {   // facts are for the u16 bank
+        tape_hl_intercept(addr);
+    }
+#endif
+}
+
+/* All jumps go through this function */
 void jump(unsigned short addr)
 {
-    /* don't simulate any functions yet */
+    /* don't simulate many functions yet */
     pc = addr;
     return;
 
@@ -1354,7 +1934,24 @@ void jump(unsigned short addr)
 #endif
 }
 
+// Start up with fresh batteries: the RTC too
 void workslate_hw_reset(void)
+{
+    power_up_reset();
+
+    if (rtc_epoch >= 0) {
+        rtc_set_time(rtc_epoch);
+    } else {
+        // set RTC to illegal time so firmware sets it to default date
+        rtc_mem[0]=255;  // seconds
+        rtc_mem[2]=255;  // minutes
+        rtc_mem[4]=255;  // hours
+    }
+    virtual_rtc_cycles = 0;
+}
+
+// Power on: everything but the RTC
+static void power_up_reset(void)
 {
     // printf("DEBUG - reached %s at " __FILE__ ":%d\n", __FUNCTION__, __LINE__);
     ram[ADDR_PORT1] = 0x07;  // start in bank 0 (u16.bin).  Power requested on (bit 2)
@@ -1362,17 +1959,17 @@ void workslate_hw_reset(void)
 
     memset(ram_tag, 0, TAGSIZE);
 
-    // set RTC to illegal time so firmware sets it to default date
-    rtc_mem[0]=255;  // seconds
-    rtc_mem[2]=255;  // minutes
-    rtc_mem[4]=255;  // hours
-
     // PLA
-    reg_CSTAPER0 = 0x04; // 0x04 means tape head in position to pass self test
+    tape_reset();   // tape head in position to pass self test
 
     // Timer:
     // mwrite(ADDR_TRCSR, 0x20);
     mwrite(ADDR_TCSR, 0x00);
     Timer_Counter = 0x0000;
     Timer_OutputCompare = 0xFFFF;
+
+    lcd_watch_init(E_CLOCK_FREQUENCY);
+#ifndef WASM
+    pacing_init(E_CLOCK_FREQUENCY);
+#endif
 }
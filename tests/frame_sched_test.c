@@ -0,0 +1,167 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Drives the web version's frame scheduler (src/frame_sched.c) with a fake
+// clock and a fake host: 60 animation frames a second, where a busy cycle
+// costs a set time and a cycle skipped in SLP costs next to nothing.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "frame_sched.h"
+
+#define CLOCK_HZ        1228800
+#define FRAME_MS        (1000.0 / 60)
+#define SLEEP_COST_MS   0.000001            // host time to skip one SLP cycle
+
+static int failures = 0;
+
+#define CHECK(cond, ...)  if (!(cond)) { printf(__VA_ARGS__); printf("\n"); failures++; }
+
+// The fake host and machine
+static double now_ms;
+static double start_ms;
+static double emulated_ms;                  // how far the emulation has got
+static double spent_ms;                     // host time the last frame took
+static uint32_t last_budget;
+
+// One animation frame.  'busy' is the part of the cycles the firmware is
+// really running (the rest it sleeps through), 'cost_ms' the host time per
+// busy cycle.
+static void frame(int state, double busy, double cost_ms)
+{
+    uint32_t cycles, slept;
+
+    now_ms += FRAME_MS;
+    cycles = last_budget = frame_sched_begin(now_ms, state);
+    slept = (state == FRAME_OFF) ? cycles : (uint32_t) (cycles * (1 - busy));
+    spent_ms = (cycles - slept) * cost_ms + slept * SLEEP_COST_MS;
+    frame_sched_end(now_ms + spent_ms, cycles, slept);
+    emulated_ms += cycles * 1000.0 / CLOCK_HZ;
+}
+
+static void start(void)
+{
+    frame_sched_init(CLOCK_HZ);
+    now_ms = 1000;
+    emulated_ms = 0;
+    frame(FRAME_AWAKE, 1, 0.0001);          // the first frame only starts the clock
+    start_ms = now_ms;
+    emulated_ms = 0;
+}
+
+static double behind_ms(void)
+{
+    return (now_ms - start_ms) - emulated_ms;
+}
+
+// A fast host keeps up with busy firmware, and nothing is owed
+static void test_busy_fast_host(void)
+{
+    start();
+    for (int i = 0; i < 600; i++) {
+        frame(FRAME_AWAKE, 1, 0.0001);
+    }
+    CHECK(behind_ms() < FRAME_MS, "fast host, busy: %.1f msec behind after 10 sec", behind_ms());
+    CHECK(spent_ms < FRAME_WORK_MS, "fast host, busy: %.2f msec a frame", spent_ms);
+}
+
+// A slow host gets FRAME_WORK_MS of work a frame, and falls behind
+static void test_busy_slow_host(void)
+{
+    start();
+    for (int i = 0; i < 600; i++) {
+        frame(FRAME_AWAKE, 1, 0.002);
+    }
+    CHECK(spent_ms > FRAME_WORK_MS * 0.9 && spent_ms < FRAME_WORK_MS * 1.1,
+          "slow host: %.2f msec a frame, not %.1f", spent_ms, FRAME_WORK_MS);
+}
+
+// Idle firmware on a slow host: sleeping frames get only FRAME_SLEEP_MS, and
+// that is enough to keep up
+static void test_asleep(void)
+{
+    double most = 0;
+
+    start();
+    for (int i = 0; i < 600; i++) {
+        frame(FRAME_ASLEEP, 0.02, 0.002);
+        if (i >= 60 && spent_ms > most) {
+            most = spent_ms;
+        }
+    }
+    CHECK(behind_ms() < FRAME_MS, "asleep: %.1f msec behind after 10 sec", behind_ms());
+    CHECK(most <= FRAME_SLEEP_MS * 1.1, "asleep: %.2f msec a frame, not %.1f", most, FRAME_SLEEP_MS);
+}
+
+// Cycles skipped in SLP don't make busy cycles look cheap: when the firmware
+// wakes up and gets busy, the first frame still fits in FRAME_WORK_MS
+static void test_wake_up(void)
+{
+    start();
+    for (int i = 0; i < 600; i++) {
+        frame(FRAME_ASLEEP, 0.02, 0.002);
+    }
+    frame(FRAME_AWAKE, 1, 0.002);
+    CHECK(spent_ms < FRAME_WORK_MS * 1.5, "waking up: %.2f msec frame", spent_ms);
+}
+
+// After the tab was throttled, no more than FRAME_CATCHUP_MS is made up
+static void test_throttled(void)
+{
+    double before;
+
+    start();
+    for (int i = 0; i < 60; i++) {
+        frame(FRAME_AWAKE, 1, 0.0001);
+    }
+    now_ms += 5000;                         // a background tab
+    before = emulated_ms;
+    for (int i = 0; i < 60; i++) {
+        frame(FRAME_AWAKE, 1, 0.0001);
+    }
+    CHECK(emulated_ms - before < FRAME_CATCHUP_MS + 60 * FRAME_MS + 1,
+          "throttled: made up %.1f msec", emulated_ms - before - 60 * FRAME_MS);
+    CHECK(emulated_ms - before > FRAME_CATCHUP_MS + 59 * FRAME_MS,
+          "throttled: only made up %.1f msec", emulated_ms - before - 60 * FRAME_MS);
+}
+
+// Switched off: FRAME_MIN_CYCLES a frame, and nothing to catch up on at power on
+static void test_off(void)
+{
+    start();
+    for (int i = 0; i < 600; i++) {
+        frame(FRAME_OFF, 0, 0.0001);
+        CHECK(last_budget == FRAME_MIN_CYCLES, "off: budget %u", last_budget);
+    }
+    frame(FRAME_AWAKE, 1, 0.0001);
+    CHECK(last_budget < FRAME_MS * CLOCK_HZ / 1000 + 1, "power on: budget %u", last_budget);
+}
+
+int main(void)
+{
+    test_busy_fast_host();
+    test_busy_slow_host();
+    test_asleep();
+    test_wake_up();
+    test_throttled();
+    test_off();
+
+    printf("frame_sched_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Checks the glyph atlas (src/lcd_font.c) that the web version draws from:
+// every glyph is where LCD_ATLAS_X/Y say, its pixels follow lcd_font[] (and
+// the inverse for codes 80-FF), the gaps between LCD pixels are background,
+// and lcd_atlas_build() writes the same colours as RGBA.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "lcd_font.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...)  if (!(cond)) { printf(__VA_ARGS__); printf("\n"); failures++; }
+
+static void check_glyphs(void)
+{
+    for (int c = 0; c < 256; c++) {
+        int inverse = c & 0x80;
+        uint32_t gap = inverse ? LCD_RGB_ON : LCD_RGB_OFF;
+
+        for (int py = 0; py < LCD_CHAR_HEIGHT; py++) {
+            for (int px = 0; px < LCD_CHAR_WIDTH; px++) {
+                int lit = ((lcd_font[c & 0x7F][px] >> py) & 1) ^ !!inverse;
+                int x = LCD_ATLAS_X(c) + px * LCD_ATLAS_SCALE;
+                int y = LCD_ATLAS_Y(c) + py * LCD_ATLAS_SCALE;
+                uint32_t want = lit ? LCD_RGB_ON : LCD_RGB_OFF;
+
+                CHECK(lcd_atlas_pixel(x, y) == want, "glyph %02X pixel %d,%d: %06X, not %06X",
+                      c, px, py, lcd_atlas_pixel(x, y), want);
+                CHECK(lcd_atlas_pixel(x + LCD_ATLAS_SCALE - 2, y + LCD_ATLAS_SCALE - 2) == want,
+                      "glyph %02X pixel %d,%d isn't solid", c, px, py);
+                CHECK(lcd_atlas_pixel(x + LCD_ATLAS_SCALE - 1, y) == gap &&
+                      lcd_atlas_pixel(x, y + LCD_ATLAS_SCALE - 1) == gap,
+                      "glyph %02X pixel %d,%d has no gap", c, px, py);
+            }
+        }
+    }
+}
+
+static void check_build(void)
+{
+    uint8_t *rgba = malloc(LCD_ATLAS_WIDTH * LCD_ATLAS_HEIGHT * 4);
+    int bad = 0;
+
+    if (!rgba) {
+        CHECK(0, "out of memory");
+        return;
+    }
+    lcd_atlas_build(rgba);
+    for (int y = 0; y < LCD_ATLAS_HEIGHT && !bad; y++) {
+        for (int x = 0; x < LCD_ATLAS_WIDTH && !bad; x++) {
+            const uint8_t *p = rgba + (y * LCD_ATLAS_WIDTH + x) * 4;
+            uint32_t rgb = lcd_atlas_pixel(x, y);
+
+            bad = p[0] != (rgb >> 16) || p[1] != ((rgb >> 8) & 0xFF) || p[2] != (rgb & 0xFF) || p[3] != 0xFF;
+            CHECK(!bad, "lcd_atlas_build() at %d,%d: %02X %02X %02X %02X, not %06X",
+                  x, y, p[0], p[1], p[2], p[3], rgb);
+        }
+    }
+    free(rgba);
+}
+
+int main(void)
+{
+    CHECK(LCD_ATLAS_X(0x41) == 1 * LCD_ATLAS_GLYPH_WIDTH && LCD_ATLAS_Y(0x41) == 4 * LCD_ATLAS_GLYPH_HEIGHT,
+          "'A' isn't at column 1, row 4");
+    CHECK(LCD_ATLAS_Y(0xFF) + LCD_ATLAS_GLYPH_HEIGHT == LCD_ATLAS_HEIGHT, "the last glyph isn't at the bottom");
+    check_glyphs();
+    check_build();
+
+    printf("lcd_font_test: %s\n", failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,334 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Plays back an LCD recording (see src/lcdrec.h) made with --record-lcd:
+//
+//     lcdplay [options] file
+//
+//   --speed n          n times real time (default 1), or 'max'
+//   --fps n            frames per second (default 30)
+//   --frames out.png   Don't play, write a file for each frame where the
+//                      screen changed: out00042.png is the screen 42/fps
+//                      seconds in (or .ppm)
+//   --dump             Don't play, print the events as text
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "lcdrec.h"
+#include "lcd_font.h"
+#include "snapshot.h"
+
+static uint8_t cells[LCDREC_CELLS];
+static uint16_t cursor = 0;
+static uint8_t mode = 0;
+static uint32_t clock_hz;
+
+/////////////////////////////
+// Terminal
+
+static uint8_t shown[LCDREC_CELLS];
+
+static void put_glyph(uint8_t c)
+{
+    c &= 0x7F;
+    if (c >= 0x20) {
+        putchar(c);
+        return;
+    }
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        if ((iso_font[c] >> shift) || !shift) {
+            putchar(iso_font[c] >> shift);
+        }
+    }
+}
+
+static void term_frame(uint64_t cycle)
+{
+    int at = -1;
+
+    for (int p = 0; p < LCDREC_CELLS; p++) {
+        if (cells[p] == shown[p]) {
+            continue;
+        }
+        shown[p] = cells[p];
+        if (p != at) {
+            printf("\033[%d;%dH", p / LCDREC_COLS + 2, p % LCDREC_COLS + 2);
+        }
+        printf(cells[p] & 0x80 ? "\033[7m" : "\033[27m");
+        put_glyph(cells[p]);
+        at = p + 1;
+        if (at % LCDREC_COLS == 0) {
+            at = -1;
+        }
+    }
+    printf("\033[27m\033[%d;2H%.2f s", LCDREC_ROWS + 3, (double) cycle / clock_hz);
+    if ((mode & 0x08) && cursor < LCDREC_CELLS) {
+        printf("\033[%d;%dH\033[?25h", cursor / LCDREC_COLS + 2, cursor % LCDREC_COLS + 2);
+    } else {
+        printf("\033[?25l");
+    }
+    fflush(stdout);
+}
+
+static void term_start(void)
+{
+    printf("\033[H\033[2J+");
+    for (int x = 0; x < LCDREC_COLS; x++) {
+        putchar('-');
+    }
+    printf("+\n");
+    for (int y = 0; y < LCDREC_ROWS; y++) {
+        printf("|%*s|\n", LCDREC_COLS, "");
+    }
+    printf("+");
+    for (int x = 0; x < LCDREC_COLS; x++) {
+        putchar('-');
+    }
+    printf("+\n");
+    memset(shown, ' ', sizeof(shown));
+}
+
+// Sleep until the emulated time (at this speed) catches up with the cycle
+static void wait_for(uint64_t cycle, double speed)
+{
+    static struct timespec start;
+    struct timespec now, d;
+    double late;
+
+    if (!start.tv_sec) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    late = (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9
+           - (double) cycle / clock_hz / speed;
+    if (late < 0) {
+        d.tv_sec = (time_t) -late;
+        d.tv_nsec = (long) ((-late - d.tv_sec) * 1e9);
+        nanosleep(&d, NULL);
+    }
+}
+
+/////////////////////////////
+// Events
+
+// here = where the cursor was before the event
+static void dump(uint64_t cycle, const uint8_t *e, uint16_t here)
+{
+    uint16_t addr = e[1] | (e[2] << 8);
+
+    printf("%12llu cyc %11.6f s - ", (unsigned long long) cycle, (double) cycle / clock_hz);
+    switch (e[0]) {
+        case LCDREC_HERE:
+            printf("%2d,%-2d = %02x\n", here % LCDREC_COLS, here / LCDREC_COLS, e[1]);
+            break;
+        case LCDREC_CELL:
+            printf("%2d,%-2d = %02x\n", addr % LCDREC_COLS, addr / LCDREC_COLS, e[3]);
+            break;
+        case LCDREC_CURSOR:
+            printf("cursor %d,%d\n", addr % LCDREC_COLS, addr / LCDREC_COLS);
+            break;
+        case LCDREC_MODE:
+            printf("mode %02x\n", e[1]);
+            break;
+        case LCDREC_SCREEN:
+            printf("whole screen\n");
+            break;
+    }
+}
+
+// Apply one event, returns its length or 0 if it is cut off or unknown
+static uint32_t apply(const uint8_t *e, uint32_t left)
+{
+    uint16_t addr;
+
+    switch (e[0]) {
+        case LCDREC_HERE:
+            if (left < 2) {
+                return 0;
+            }
+            if (cursor < LCDREC_CELLS) {
+                cells[cursor] = e[1];
+            }
+            cursor++;
+            return 2;
+        case LCDREC_CELL:
+            if (left < 4) {
+                return 0;
+            }
+            addr = e[1] | (e[2] << 8);
+            if (addr < LCDREC_CELLS) {
+                cells[addr] = e[3];
+            }
+            cursor = addr + 1;
+            return 4;
+        case LCDREC_CURSOR:
+            if (left < 3) {
+                return 0;
+            }
+            cursor = e[1] | (e[2] << 8);
+            return 3;
+        case LCDREC_MODE:
+            if (left < 2) {
+                return 0;
+            }
+            mode = e[1];
+            return 2;
+        case LCDREC_SCREEN:
+            if (left < 1 + LCDREC_CELLS + 3) {
+                return 0;
+            }
+            memcpy(cells, e + 1, LCDREC_CELLS);
+            cursor = e[1 + LCDREC_CELLS] | (e[2 + LCDREC_CELLS] << 8);
+            mode = e[3 + LCDREC_CELLS];
+            return 1 + LCDREC_CELLS + 3;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = NULL;
+    const char *frames = NULL;
+    const char *ext = "";
+    char base[1024], name[1100];
+    double speed = 1;
+    uint32_t fps = 30;
+    int dumping = 0;
+    uint8_t *data;
+    long size;
+    uint32_t at, n;
+    uint16_t cols, rows, here;
+    uint64_t cycle = 0, frame_cycles, frame = 0, d;
+    int changed = 0;
+    FILE *f;
+
+    for (int x = 1; x < argc; x++) {
+        if (!strcmp(argv[x], "--speed") && x + 1 < argc) {
+            x++;
+            speed = strcmp(argv[x], "max") ? atof(argv[x]) : 0;
+        } else if (!strcmp(argv[x], "--fps") && x + 1 < argc) {
+            fps = strtoul(argv[++x], NULL, 0);
+        } else if (!strcmp(argv[x], "--frames") && x + 1 < argc) {
+            frames = argv[++x];
+        } else if (!strcmp(argv[x], "--dump")) {
+            dumping = 1;
+        } else if (argv[x][0] != '-' && !filename) {
+            filename = argv[x];
+        } else {
+            printf("lcdplay [--speed n|max] [--fps n] [--frames out.png] [--dump] file\n");
+            return 1;
+        }
+    }
+    if (!filename || !fps || speed < 0) {
+        printf("lcdplay [--speed n|max] [--fps n] [--frames out.png] [--dump] file\n");
+        return 1;
+    }
+
+    f = fopen(filename, "rb");
+    if (!f) {
+        perror(filename);
+        return 1;
+    }
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    data = malloc(size + 1);
+    if (!data || fread(data, 1, size, f) != (size_t) size) {
+        perror(filename);
+        return 1;
+    }
+    fclose(f);
+    if (size < LCDREC_HEADER_SIZE || memcmp(data, LCDREC_MAGIC, 8)) {
+        printf("%s: not an LCD recording\n", filename);
+        return 1;
+    }
+    memcpy(&clock_hz, data + 8, 4);
+    memcpy(&cols, data + 12, 2);
+    memcpy(&rows, data + 14, 2);
+    if (!clock_hz || cols != LCDREC_COLS || rows != LCDREC_ROWS) {
+        printf("%s: unsupported screen size\n", filename);
+        return 1;
+    }
+    frame_cycles = clock_hz / fps;
+
+    if (frames) {
+        ext = strrchr(frames, '.');
+        if (!ext || (strcmp(ext, ".png") && strcmp(ext, ".ppm"))) {
+            printf("Frame file name must end in .png or .ppm\n");
+            return 1;
+        }
+        snprintf(base, sizeof(base), "%.*s", (int) (ext - frames), frames);
+    } else if (!dumping) {
+        term_start();
+    }
+
+    // A frame is shown when the first event after it comes along, so each
+    // frame has everything that happened up to its end
+    at = LCDREC_HEADER_SIZE;
+    while (at < size) {
+        d = 0;
+        for (int shift = 0; at < size; shift += 7) {
+            d |= (uint64_t) (data[at] & 0x7F) << shift;
+            if (!(data[at++] & 0x80)) {
+                break;
+            }
+        }
+        cycle += d;
+        if (changed && cycle / frame_cycles != frame) {
+            if (frames) {
+                snprintf(name, sizeof(name), "%s%05llu%s", base, (unsigned long long) frame + 1, ext);
+                snapshot_write(name, cells, (frame + 1) * frame_cycles);
+            } else if (!dumping) {
+                if (speed) {
+                    wait_for((frame + 1) * frame_cycles, speed);
+                }
+                term_frame((frame + 1) * frame_cycles);
+            }
+            changed = 0;
+        }
+        frame = cycle / frame_cycles;
+
+        if (at >= size) {
+            break;
+        }
+        here = cursor;
+        n = apply(data + at, size - at);
+        if (!n) {
+            printf("%s: bad event %02x at offset %u\n", filename, data[at], at);
+            break;
+        }
+        if (dumping) {
+            dump(cycle, data + at, here);
+        }
+        at += n;
+        changed = 1;
+    }
+
+    if (changed && frames) {
+        snprintf(name, sizeof(name), "%s%05llu%s", base, (unsigned long long) frame + 1, ext);
+        snapshot_write(name, cells, (frame + 1) * frame_cycles);
+    } else if (!frames && !dumping) {
+        term_frame(cycle);
+        printf("\033[?25h\033[%d;1H", LCDREC_ROWS + 4);
+    }
+    free(data);
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*   Workslate WK-100 Emulator
+ *   Copyright (C) 2025 John Maushammer
+ *
+ * This is free software; you can redistribute it and/or modify it under the
+ * terms of the GNU General Public License as published by the Free Software
+ * Foundation; either version 1, or (at your option) any later version.
+ *
+ * It is distributed in the hope that it will be useful, but WITHOUT ANY
+ * WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ * FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ * details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this software; see the file COPYING.  If not, write to the Free Software Foundation,
+ * 675 Mass Ave, Cambridge, MA 02139, USA.
+ */
+
+// Prints a binary register access log (see src/reglog.h) as text:
+//
+//     reglog_decode [register_access_log.bin]
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "reglog.h"
+
+static const char *reg_name(uint8_t reg)
+{
+    static char name[16];
+
+    switch (reg) {
+        case 0x08: return "TCSR";
+        case 0x11: return "TRCSR";
+        case 0x12: return "SCRDR";
+        case 0x13: return "SCTDR";
+        case 0x2C: return "CSTAPE0";
+        case 0x2D: return "CSTAPE1";
+        case 0x4C: return "RTC_C";
+    }
+    snprintf(name, sizeof(name), "reg %02x", reg);
+    return name;
+}
+
+int main(int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : "register_access_log.bin";
+    static const char *kinds[] = { "read ", "write", "event" };
+    uint8_t hdr[REGLOG_HEADER_SIZE];
+    struct reglog_record r;
+    uint32_t size, clock_hz;
+    FILE *f;
+
+    f = fopen(filename, "rb");
+    if (!f) {
+        perror(filename);
+        return 1;
+    }
+    if (fread(hdr, 1, sizeof(hdr), f) != sizeof(hdr) || memcmp(hdr, REGLOG_MAGIC, 8)) {
+        printf("%s: not a register log\n", filename);
+        return 1;
+    }
+    memcpy(&size, hdr + 8, 4);
+    memcpy(&clock_hz, hdr + 12, 4);
+    if (size != sizeof(r) || !clock_hz) {
+        printf("%s: unsupported record size %u\n", filename, size);
+        return 1;
+    }
+
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        printf("%12llu cyc %11.6f s - PC=%d.%04x ", (unsigned long long) r.cycle,
+               (double) r.cycle / clock_hz, r.bank, r.pc);
+        if (r.kind == REGLOG_DROPPED) {
+            printf("*** %d%s records dropped ***\n", r.value, r.value == 255 ? " or more" : "");
+        } else if (r.kind <= REGLOG_EVENT) {
+            printf("%s %-7s = %02x\n", kinds[r.kind], reg_name(r.reg), r.value);
+        } else {
+            printf("unknown record kind %d\n", r.kind);
+        }
+    }
+    fclose(f);
+    return 0;
+}